@@ -1,18 +1,26 @@
 #pragma once
 #include "common.hpp"
 
+// the functions below are templates over the complex type so that they can
+// also be evaluated in double precision (e.g. on a host, to check the
+// accuracy of the float versions used on the device). the firmware only
+// instantiates them with complexf.
+
 // given the measured raw values for short, open, and load, compute the 3 calibration coefficients
-inline array<complexf, 3> SOL_compute_coefficients(complexf sc, complexf oc, complexf load) {
-	complexf a=load, b=oc, c=sc;
-	complexf cal_X, cal_Y, cal_Z;
-	cal_Z=(2.f*a-b-c)/(b-c);
-	cal_X=a-c*(1.f-cal_Z);
+template<class C>
+inline array<C, 3> SOL_compute_coefficients(C sc, C oc, C load) {
+	typedef typename C::value_type T;
+	C a=load, b=oc, c=sc;
+	C cal_X, cal_Y, cal_Z;
+	cal_Z=(T(2)*a-b-c)/(b-c);
+	cal_X=a-c*(T(1)-cal_Z);
 	cal_Y=a/cal_X;
 
 	return {cal_X, cal_Y, cal_Z};
 }
 // given the calibration coefficients and a raw value, compute the reflection coefficient
-inline complexf SOL_compute_reflection(const array<complexf, 3>& coeffs, complexf raw) {
+template<class C>
+inline C SOL_compute_reflection(const array<C, 3>& coeffs, C raw) {
 	auto cal_X = coeffs[0];
 	auto cal_Y = coeffs[1];
 	auto cal_Z = coeffs[2];
@@ -21,8 +29,10 @@ inline complexf SOL_compute_reflection(const array<complexf, 3>& coeffs, complex
 }
 
 // given the measured raw values for S,O,L and a DUT raw value, compute the reflection coefficient
-inline complexf SOL_compute_reflection(complexf sc, complexf oc, complexf load, complexf dut) {
-	complexf a=load, b=oc, c=sc, d = dut;
+template<class C>
+inline C SOL_compute_reflection(C sc, C oc, C load, C dut) {
+	typedef typename C::value_type T;
+	C a=load, b=oc, c=sc, d = dut;
 	/*complexf cal_X, cal_Y, cal_Z;
 	cal_Z=(2.f*a-b-c)/(b-c);
 	cal_X=a-c*(1.f-cal_Z);
@@ -43,15 +53,56 @@ inline complexf SOL_compute_reflection(complexf sc, complexf oc, complexf load,
 	simplify(result)
 	*/
 
-	return -(a - d)*(b - c)/(a*(b - c) + 2.f*c*(a - b) + d*(-2.f*a + b + c));
+	return -(a - d)*(b - c)/(a*(b - c) + T(2)*c*(a - b) + d*(T(-2)*a + b + c));
 }
 
 
 // given the measured raw values for S,O,L and a DUT calibrated value, compute the outgoing power
 // gain caused by the SFG loop between the DUT and port 1.
-inline complexf SOL_compute_thru_gain(complexf sc, complexf oc, complexf load, complexf dut) {
-	complexf e11 = -(sc+oc-2.f*load) / (sc-oc);
-	complexf loopGain = e11 * dut;
-	return 1.f / (1.f - loopGain);
+template<class C>
+inline C SOL_compute_thru_gain(C sc, C oc, C load, C dut) {
+	typedef typename C::value_type T;
+	C e11 = -(sc+oc-T(2)*load) / (sc-oc);
+	C loopGain = e11 * dut;
+	return T(1) / (T(1) - loopGain);
 }
 
+// apply the full correction to one data point.
+// cal holds the calibration data of this frequency point, indexed by CAL_*.
+// refl and thru are the raw (ecal corrected) S11 and S21 values and are
+// replaced by the corrected values.
+// thruCal: CALSTAT_THRU is set; enhancedResponse: CALSTAT_ENHANCED_RESPONSE is set.
+template<class C>
+inline void SOLT_apply_correction(const array<C, CAL_ENTRIES>& cal, bool thruCal,
+								bool enhancedResponse, C& refl, C& thru) {
+	auto sc = cal[CAL_SHORT], oc = cal[CAL_OPEN], load = cal[CAL_LOAD];
+
+	// apply thru leakage correction
+	auto x1 = sc,
+		y1 = cal[CAL_ISOLN_SHORT],
+		x2 = oc,
+		y2 = cal[CAL_ISOLN_OPEN];
+	auto cal_thru_leak_r = (y1-y2)/(x1-x2);
+	auto cal_thru_leak = y2-cal_thru_leak_r*x2;
+	thru = thru - (cal_thru_leak + refl*cal_thru_leak_r);
+
+	// calculate reflection
+	auto newRefl = SOL_compute_reflection(sc, oc, load, refl);
+
+	// apply thru response correction
+	if(thruCal) {
+		auto refThru = cal[CAL_THRU];
+		auto reflThru = cal[CAL_THRU_REFL];
+		refThru = refThru - (cal_thru_leak + reflThru*cal_thru_leak_r);
+		reflThru = SOL_compute_reflection(sc, oc, load, reflThru);
+		auto thruGain = SOL_compute_thru_gain(sc, oc, load, newRefl);
+		auto refThruGain = SOL_compute_thru_gain(sc, oc, load, reflThru);
+
+		if(enhancedResponse)
+			refThru *= thruGain / refThruGain;
+
+		thru = thru / refThru;
+	}
+
+	refl = newRefl;
+}
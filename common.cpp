@@ -31,6 +31,8 @@ void properties_t::setFieldsToDefault() {
 	_adf4350_txPower = 3;
 	_si5351_txPower = 1;
 	_measurement_mode = MEASURE_MODE_FULL;
+	_td_kaiser_beta = 60;
+	_td_chebyshev_atten = 0;
 
 	setCalDataToDefault();
 	memcpy(_trace, def_trace, sizeof(_trace));
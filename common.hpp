@@ -62,8 +62,23 @@ static constexpr uint32_t FREQUENCY_CHANGE_OVER	= 140000000;
 #define FFT_SIZE 256
 #elif SWEEP_POINTS_MAX < 512
 #define FFT_SIZE 512
+#elif SWEEP_POINTS_MAX < 1024
+#define FFT_SIZE 1024
+#elif SWEEP_POINTS_MAX < 2048
+#define FFT_SIZE 2048
+#elif SWEEP_POINTS_MAX < 4096
+#define FFT_SIZE 4096
 #else
-#error "Need update FFT table for more points size"
+#error "FFT_SIZE larger than 4096 is not supported"
+#endif
+
+// without an FPU, fft.cpp converts to q31 and transforms in fixed point
+#ifndef FFT_FIXED_POINT
+#if defined(GD32F3_NOFPU) || (defined(__arm__) && !defined(__ARM_FP))
+#define FFT_FIXED_POINT 1
+#else
+#define FFT_FIXED_POINT 0
+#endif
 #endif
 
 #define ECAL_PARTIAL
@@ -115,6 +130,13 @@ static constexpr uint32_t FREQUENCY_CHANGE_OVER	= 140000000;
 #define TD_WINDOW_NORMAL (0b00<<3)
 #define TD_WINDOW_MINIMUM (0b01<<3)
 #define TD_WINDOW_MAXIMUM (0b10<<3)
+// TD_WINDOW_CUSTOM selects the window given by TD_WINDOW_TYPE
+#define TD_WINDOW_CUSTOM  (0b11<<3)
+#define TD_WINDOW_TYPE    (0b11<<6)
+#define TD_WINDOW_KAISER          (TD_WINDOW_CUSTOM | (0b00<<6)) // beta from _td_kaiser_beta
+#define TD_WINDOW_HANN            (TD_WINDOW_CUSTOM | (0b01<<6))
+#define TD_WINDOW_BLACKMAN_HARRIS (TD_WINDOW_CUSTOM | (0b10<<6))
+#define TD_WINDOW_CHEBYSHEV       (TD_WINDOW_CUSTOM | (0b11<<6)) // sidelobes from _td_chebyshev_atten
 // L/C match enable option
 #define TD_LC_MATH        (1<<5)
 
@@ -199,12 +221,16 @@ struct alignas(4) properties_t {
   marker_t _markers[MARKERS_MAX];
   float _velocity_factor; // %
   int _active_marker;
-  uint8_t _domain_mode; /* 0bxxxxxffm : where ff: TD_FUNC m: DOMAIN_MODE */
+  uint8_t _domain_mode; /* 0bttlwwffm : where tt: TD_WINDOW_TYPE l: TD_LC_MATH ww: TD_WINDOW ff: TD_FUNC m: DOMAIN_MODE */
   uint8_t _marker_smith_format;
   uint8_t _avg;
   uint8_t _adf4350_txPower; // 0 to 3
   uint8_t _si5351_txPower; // 0 to 3
   uint8_t _measurement_mode; //See enum MeasurementMode.
+  // parameters of the TD_WINDOW_CUSTOM windows; these occupy what was
+  // padding before checksum, so the layout of older saves is unchanged.
+  uint8_t _td_kaiser_beta; // beta * 10
+  uint8_t _td_chebyshev_atten; // dB, 0 = default
 
   uint32_t checksum;
 
@@ -0,0 +1,92 @@
+#pragma once
+#include <stdint.h>
+#include <string.h>
+#include <math.h>
+
+// approximations of libm functions for the plotting path, where newlib's
+// soft float implementations are slow on the nofpu build. each function
+// states its maximum error, measured on the host against libm over the
+// whole float range that can occur in plotting (finite, non-negative
+// arguments for log2/rsqrt).
+
+static inline uint32_t fast_float_bits(float x) {
+	uint32_t i;
+	memcpy(&i, &x, sizeof(i));
+	return i;
+}
+
+static inline float fast_bits_float(uint32_t i) {
+	float x;
+	memcpy(&x, &i, sizeof(x));
+	return x;
+}
+
+// log2(x); absolute error < 3e-5.
+// x = 2^e * m with m in [sqrt(1/2), sqrt(2)), and log2(m) = f * p(f)
+// with f = m - 1 and p a least squares fit of degree 4.
+// returns -INFINITY for x <= 0.
+static inline float fast_log2f(float x) {
+	if (!(x > 0))
+		return -INFINITY;
+	int bias = 127;
+	if (x < 1.17549435e-38f) {
+		// denormal: scale into the normal range first
+		x *= 8388608.f; // 2^23
+		bias += 23;
+	}
+	uint32_t i = fast_float_bits(x);
+	int e = (int)((i >> 23) & 0xff) - bias;
+	// mantissa in [1, 2)
+	uint32_t mi = (i & 0x007fffff) | 0x3f800000;
+	if (mi > 0x3fb504f3) { // > sqrt(2)
+		mi -= 0x00800000; // halve, m in [sqrt(1/2), 1)
+		e++;
+	}
+	float f = fast_bits_float(mi) - 1.f;
+	float p = 1.442521594f + f * (-0.720400989f + f * (0.488226395f
+		+ f * (-0.392464830f + f * 0.242392708f)));
+	return e + f * p;
+}
+
+// log10(x); absolute error < 1.5e-5 (3e-4 dB in 20*log10).
+static inline float fast_log10f(float x) {
+	return fast_log2f(x) * 0.30102999566f;
+}
+
+// atan2(y, x) in radians; absolute error < 5e-6 rad.
+// the argument is reduced to z = min/max in [0, 1] and atan(z) is
+// evaluated with the odd degree 11 polynomial of Abramowitz & Stegun
+// 4.4.49. returns 0 for x = y = 0, like libm.
+static inline float fast_atan2f(float y, float x) {
+	float ax = fabsf(x), ay = fabsf(y);
+	float mx = ax > ay ? ax : ay;
+	float mn = ax > ay ? ay : ax;
+	if (mx == 0)
+		return 0;
+	float z = mn / mx;
+	float z2 = z * z;
+	float a = z * (0.99997726f + z2 * (-0.33262347f + z2 * (0.19354346f
+		+ z2 * (-0.11643287f + z2 * (0.05265332f + z2 * -0.01172120f)))));
+	if (ay > ax)
+		a = (float)M_PI_2 - a;
+	if (x < 0)
+		a = (float)M_PI - a;
+	return y < 0 ? -a : a;
+}
+
+// 1/sqrt(x) for normal x > 0; relative error < 5e-6.
+// initial guess from the exponent bits, refined by two newton steps.
+static inline float fast_rsqrtf(float x) {
+	float y = fast_bits_float(0x5f3759df - (fast_float_bits(x) >> 1));
+	float h = 0.5f * x;
+	y = y * (1.5f - h * y * y);
+	y = y * (1.5f - h * y * y);
+	return y;
+}
+
+// sqrt(x) for normal x >= 0; relative error < 5e-6.
+static inline float fast_sqrtf(float x) {
+	if (!(x > 0))
+		return 0;
+	return x * fast_rsqrtf(x);
+}
@@ -27,187 +27,333 @@
 #include <stdint.h>
 #include "common.hpp"
 
-// Use table increase transform speed, increase code size on ~700 bytes
-// Use compact table, increase code size on ~200 bytes, and not decrease speed
-#define FFT_USE_SIN_COS_TABLE
-
-static uint16_t reverse_bits(uint16_t x, int n) {
-	uint16_t result = 0;
-	for (int i = 0; i < n; i++, x >>= 1)
-		result = (result << 1) | (x & 1U);
-	return result;
+// FFT_SIZE = 2^FFT_N
+static constexpr int fft_log2(int n) {
+	return n <= 1 ? 0 : 1 + fft_log2(n / 2);
 }
-#ifdef FFT_USE_SIN_COS_TABLE
-#if FFT_SIZE == 256
-static const float sin_table_256[] = {
-	/*
-	 * float has about 7.2 digits of precision
-		for (uint8_t i = 0; i < FFT_SIZE - (FFT_SIZE / 4); i++) {
-			printf("% .8f,%c", sin(2 * M_PI * i / FFT_SIZE), i % 8 == 7 ? '\n' : ' ');
+#define FFT_N fft_log2(FFT_SIZE)
+static_assert((1 << FFT_N) == FFT_SIZE, "FFT_SIZE must be a power of 2");
+static_assert(FFT_SIZE >= 16 && FFT_SIZE <= 4096, "unsupported FFT_SIZE");
+
+// tables are generated at compile time and placed in flash.
+struct fft_tables_t {
+	// sin(2*pi*i/FFT_SIZE) for i in [0, FFT_SIZE); cos(x) = sin(x + FFT_SIZE/4).
+	// the butterflies below use indexes up to 3/4 FFT_SIZE for sin and
+	// FFT_SIZE for cos.
+	float sin[FFT_SIZE + 1];
+#if FFT_FIXED_POINT
+	// the same table in q31
+	int32_t sin_q31[FFT_SIZE + 1];
+#endif
+	// bit reversal permutation
+	uint16_t bitrev[FFT_SIZE];
+
+	// sin(pi/2 * i/q) for 0 <= i <= q, taylor series (|x| <= pi/2)
+	static constexpr double sin_quarter(int i, int q) {
+		double x = (double)i / q * 1.57079632679489661923;
+		double term = x, sum = x;
+		for (int n = 1; n < 14; n++) {
+			term *= -x * x / ((2 * n) * (2 * n + 1));
+			sum += term;
 		}
-	*/
-	 // for FFT_SIZE = 256
-	 0.00000000,  0.02454123,  0.04906767,  0.07356456,  0.09801714,  0.12241068,  0.14673047,  0.17096189,
-	 0.19509032,  0.21910124,  0.24298018,  0.26671276,  0.29028468,  0.31368174,  0.33688985,  0.35989504,
-	 0.38268343,  0.40524131,  0.42755509,  0.44961133,  0.47139674,  0.49289819,  0.51410274,  0.53499762,
-	 0.55557023,  0.57580819,  0.59569930,  0.61523159,  0.63439328,  0.65317284,  0.67155895,  0.68954054,
-	 0.70710678,  0.72424708,  0.74095113,  0.75720885,  0.77301045,  0.78834643,  0.80320753,  0.81758481,
-	 0.83146961,  0.84485357,  0.85772861,  0.87008699,  0.88192126,  0.89322430,  0.90398929,  0.91420976,
-	 0.92387953,  0.93299280,  0.94154407,  0.94952818,  0.95694034,  0.96377607,  0.97003125,  0.97570213,
-	 0.98078528,  0.98527764,  0.98917651,  0.99247953,  0.99518473,  0.99729046,  0.99879546,  0.99969882,
-	 1.00000000,/*  0.99969882,  0.99879546,  0.99729046,  0.99518473,  0.99247953,  0.98917651,  0.98527764,
-	 0.98078528,  0.97570213,  0.97003125,  0.96377607,  0.95694034,  0.94952818,  0.94154407,  0.93299280,
-	 0.92387953,  0.91420976,  0.90398929,  0.89322430,  0.88192126,  0.87008699,  0.85772861,  0.84485357,
-	 0.83146961,  0.81758481,  0.80320753,  0.78834643,  0.77301045,  0.75720885,  0.74095113,  0.72424708,
-	 0.70710678,  0.68954054,  0.67155895,  0.65317284,  0.63439328,  0.61523159,  0.59569930,  0.57580819,
-	 0.55557023,  0.53499762,  0.51410274,  0.49289819,  0.47139674,  0.44961133,  0.42755509,  0.40524131,
-	 0.38268343,  0.35989504,  0.33688985,  0.31368174,  0.29028468,  0.26671276,  0.24298018,  0.21910124,
-	 0.19509032,  0.17096189,  0.14673047,  0.12241068,  0.09801714,  0.07356456,  0.04906767,  0.02454123,
-	 0.00000000, -0.02454123, -0.04906767, -0.07356456, -0.09801714, -0.12241068, -0.14673047, -0.17096189,
-	-0.19509032, -0.21910124, -0.24298018, -0.26671276, -0.29028468, -0.31368174, -0.33688985, -0.35989504,
-	-0.38268343, -0.40524131, -0.42755509, -0.44961133, -0.47139674, -0.49289819, -0.51410274, -0.53499762,
-	-0.55557023, -0.57580819, -0.59569930, -0.61523159, -0.63439328, -0.65317284, -0.67155895, -0.68954054,
-	-0.70710678, -0.72424708, -0.74095113, -0.75720885, -0.77301045, -0.78834643, -0.80320753, -0.81758481,
-	-0.83146961, -0.84485357, -0.85772861, -0.87008699, -0.88192126, -0.89322430, -0.90398929, -0.91420976,
-	-0.92387953, -0.93299280, -0.94154407, -0.94952818, -0.95694034, -0.96377607, -0.97003125, -0.97570213,
-	-0.98078528, -0.98527764, -0.98917651, -0.99247953, -0.99518473, -0.99729046, -0.99879546, -0.99969882,*/
-};
-// FFT_SIZE = 2^N
-#define FFT_N     8
-// full size table:
-//   sin = sin_table[i   ]
-//   cos = sin_table[i+64]
-//#define SIN(i) sin_table_256[(i)]
-//#define COS(i) sin_table_256[(i)+64]
-
-// for size use only 0-64 indexes
-//   sin = i > 64 ? sin_table[128-i] : sin_table[   i];
-//   cos = i > 64 ?-sin_table[ i-64] : sin_table[64-i];
-#define SIN(i) ((i) > 64 ? sin_table_256[128-(i)] : sin_table_256[   (i)])
-#define COS(i) ((i) > 64 ?-sin_table_256[ (i)-64] : sin_table_256[64-(i)])
-#elif FFT_SIZE == 512
-static const float sin_table_512[] = {
-	/*
-	 * float has about 7.2 digits of precision
-		for (int i = 0; i < FFT_SIZE - (FFT_SIZE / 4); i++) {
-			printf("% .8f,%c", sin(2 * M_PI * i / FFT_SIZE), i % 8 == 7 ? '\n' : ' ');
+		return sum;
+	}
+	constexpr fft_tables_t(): sin(),
+#if FFT_FIXED_POINT
+		sin_q31(),
+#endif
+		bitrev() {
+		constexpr int q = FFT_SIZE / 4;
+		for (int i = 0; i <= FFT_SIZE; i++) {
+			int quadrant = (i / q) & 3, r = i % q;
+			double v = (quadrant & 1) ? sin_quarter(q - r, q) : sin_quarter(r, q);
+			sin[i] = (float)((quadrant & 2) ? -v : v);
+#if FFT_FIXED_POINT
+			int32_t q = (int32_t)(v * 2147483647.0 + 0.5);
+			sin_q31[i] = (quadrant & 2) ? -q : q;
+#endif
 		}
-	*/
-	 // For FFT_SIZE = 512
-	 0.00000000,  0.01227154,  0.02454123,  0.03680722,  0.04906767,  0.06132074,  0.07356456,  0.08579731,
-	 0.09801714,  0.11022221,  0.12241068,  0.13458071,  0.14673047,  0.15885814,  0.17096189,  0.18303989,
-	 0.19509032,  0.20711138,  0.21910124,  0.23105811,  0.24298018,  0.25486566,  0.26671276,  0.27851969,
-	 0.29028468,  0.30200595,  0.31368174,  0.32531029,  0.33688985,  0.34841868,  0.35989504,  0.37131719,
-	 0.38268343,  0.39399204,  0.40524131,  0.41642956,  0.42755509,  0.43861624,  0.44961133,  0.46053871,
-	 0.47139674,  0.48218377,  0.49289819,  0.50353838,  0.51410274,  0.52458968,  0.53499762,  0.54532499,
-	 0.55557023,  0.56573181,  0.57580819,  0.58579786,  0.59569930,  0.60551104,  0.61523159,  0.62485949,
-	 0.63439328,  0.64383154,  0.65317284,  0.66241578,  0.67155895,  0.68060100,  0.68954054,  0.69837625,
-	 0.70710678,  0.71573083,  0.72424708,  0.73265427,  0.74095113,  0.74913639,  0.75720885,  0.76516727,
-	 0.77301045,  0.78073723,  0.78834643,  0.79583690,  0.80320753,  0.81045720,  0.81758481,  0.82458930,
-	 0.83146961,  0.83822471,  0.84485357,  0.85135519,  0.85772861,  0.86397286,  0.87008699,  0.87607009,
-	 0.88192126,  0.88763962,  0.89322430,  0.89867447,  0.90398929,  0.90916798,  0.91420976,  0.91911385,
-	 0.92387953,  0.92850608,  0.93299280,  0.93733901,  0.94154407,  0.94560733,  0.94952818,  0.95330604,
-	 0.95694034,  0.96043052,  0.96377607,  0.96697647,  0.97003125,  0.97293995,  0.97570213,  0.97831737,
-	 0.98078528,  0.98310549,  0.98527764,  0.98730142,  0.98917651,  0.99090264,  0.99247953,  0.99390697,
-	 0.99518473,  0.99631261,  0.99729046,  0.99811811,  0.99879546,  0.99932238,  0.99969882,  0.99992470,
-	 1.00000000,/*  0.99992470,  0.99969882,  0.99932238,  0.99879546,  0.99811811,  0.99729046,  0.99631261,
-	 0.99518473,  0.99390697,  0.99247953,  0.99090264,  0.98917651,  0.98730142,  0.98527764,  0.98310549,
-	 0.98078528,  0.97831737,  0.97570213,  0.97293995,  0.97003125,  0.96697647,  0.96377607,  0.96043052,
-	 0.95694034,  0.95330604,  0.94952818,  0.94560733,  0.94154407,  0.93733901,  0.93299280,  0.92850608,
-	 0.92387953,  0.91911385,  0.91420976,  0.90916798,  0.90398929,  0.89867447,  0.89322430,  0.88763962,
-	 0.88192126,  0.87607009,  0.87008699,  0.86397286,  0.85772861,  0.85135519,  0.84485357,  0.83822471,
-	 0.83146961,  0.82458930,  0.81758481,  0.81045720,  0.80320753,  0.79583690,  0.78834643,  0.78073723,
-	 0.77301045,  0.76516727,  0.75720885,  0.74913639,  0.74095113,  0.73265427,  0.72424708,  0.71573083,
-	 0.70710678,  0.69837625,  0.68954054,  0.68060100,  0.67155895,  0.66241578,  0.65317284,  0.64383154,
-	 0.63439328,  0.62485949,  0.61523159,  0.60551104,  0.59569930,  0.58579786,  0.57580819,  0.56573181,
-	 0.55557023,  0.54532499,  0.53499762,  0.52458968,  0.51410274,  0.50353838,  0.49289819,  0.48218377,
-	 0.47139674,  0.46053871,  0.44961133,  0.43861624,  0.42755509,  0.41642956,  0.40524131,  0.39399204,
-	 0.38268343,  0.37131719,  0.35989504,  0.34841868,  0.33688985,  0.32531029,  0.31368174,  0.30200595,
-	 0.29028468,  0.27851969,  0.26671276,  0.25486566,  0.24298018,  0.23105811,  0.21910124,  0.20711138,
-	 0.19509032,  0.18303989,  0.17096189,  0.15885814,  0.14673047,  0.13458071,  0.12241068,  0.11022221,
-	 0.09801714,  0.08579731,  0.07356456,  0.06132074,  0.04906767,  0.03680722,  0.02454123,  0.01227154,
-	 0.00000000, -0.01227154, -0.02454123, -0.03680722, -0.04906767, -0.06132074, -0.07356456, -0.08579731,
-	-0.09801714, -0.11022221, -0.12241068, -0.13458071, -0.14673047, -0.15885814, -0.17096189, -0.18303989,
-	-0.19509032, -0.20711138, -0.21910124, -0.23105811, -0.24298018, -0.25486566, -0.26671276, -0.27851969,
-	-0.29028468, -0.30200595, -0.31368174, -0.32531029, -0.33688985, -0.34841868, -0.35989504, -0.37131719,
-	-0.38268343, -0.39399204, -0.40524131, -0.41642956, -0.42755509, -0.43861624, -0.44961133, -0.46053871,
-	-0.47139674, -0.48218377, -0.49289819, -0.50353838, -0.51410274, -0.52458968, -0.53499762, -0.54532499,
-	-0.55557023, -0.56573181, -0.57580819, -0.58579786, -0.59569930, -0.60551104, -0.61523159, -0.62485949,
-	-0.63439328, -0.64383154, -0.65317284, -0.66241578, -0.67155895, -0.68060100, -0.68954054, -0.69837625,
-	-0.70710678, -0.71573083, -0.72424708, -0.73265427, -0.74095113, -0.74913639, -0.75720885, -0.76516727,
-	-0.77301045, -0.78073723, -0.78834643, -0.79583690, -0.80320753, -0.81045720, -0.81758481, -0.82458930,
-	-0.83146961, -0.83822471, -0.84485357, -0.85135519, -0.85772861, -0.86397286, -0.87008699, -0.87607009,
-	-0.88192126, -0.88763962, -0.89322430, -0.89867447, -0.90398929, -0.90916798, -0.91420976, -0.91911385,
-	-0.92387953, -0.92850608, -0.93299280, -0.93733901, -0.94154407, -0.94560733, -0.94952818, -0.95330604,
-	-0.95694034, -0.96043052, -0.96377607, -0.96697647, -0.97003125, -0.97293995, -0.97570213, -0.97831737,
-	-0.98078528, -0.98310549, -0.98527764, -0.98730142, -0.98917651, -0.99090264, -0.99247953, -0.99390697,
-	-0.99518473, -0.99631261, -0.99729046, -0.99811811, -0.99879546, -0.99932238, -0.99969882, -0.99992470*/
+		for (int i = 0; i < FFT_SIZE; i++) {
+			int r = 0;
+			for (int b = 0, x = i; b < FFT_N; b++, x >>= 1)
+				r = (r << 1) | (x & 1);
+			bitrev[i] = r;
+		}
+	}
+};
+static constexpr fft_tables_t fft_tables;
+
+#define SIN(i) fft_tables.sin[(i)]
+#define COS(i) fft_tables.sin[(i) + FFT_SIZE/4]
+
+// sample arithmetic of the transform core.
+// scale(x, bits) is applied to the inputs of each stage: the fixed point
+// version divides by the stage gain (2 or 4) to avoid overflow, so its
+// output is the transform divided by n.
+struct fft_float {
+	typedef float T;
+	static float sin(uint16_t i) { return SIN(i); }
+	static float cos(uint16_t i) { return COS(i); }
+	static float mul(float a, float b) { return a * b; }
+	static float scale(float a, int bits) { (void)bits; return a; }
 };
-// FFT_SIZE = 2^N
-#define FFT_N     9
-// full size table:
-//   sin = sin_table[i    ]
-//   cos = sin_table[i+128]
-//#define SIN(i) sin_table_512[(i)    ]
-//#define COS(i) sin_table_512[(i)+128]
-
-// for size use only 0-128 indexes
-//   sin = i > 128 ? sin_table[256-i] : sin_table[    i];
-//   cos = i > 128 ?-sin_table[i-128] : sin_table[128-i];
-#define SIN(i) ((i) > 128 ? sin_table_512[256-(i)] : sin_table_512[    (i)])
-#define COS(i) ((i) > 128 ?-sin_table_512[(i)-128] : sin_table_512[128-(i)])
-#else
-#error "Need build table for new FFT size"
-#endif
 
+#if FFT_FIXED_POINT
+struct fft_q31 {
+	typedef int32_t T;
+	static int32_t sin(uint16_t i) { return fft_tables.sin_q31[i]; }
+	static int32_t cos(uint16_t i) { return fft_tables.sin_q31[i + FFT_SIZE/4]; }
+	static int32_t mul(int32_t a, int32_t b) { return (int32_t)(((int64_t)a * b) >> 31); }
+	static int32_t scale(int32_t a, int bits) { return a >> bits; }
+};
 #endif
 
 /***
- * dir = forward: 0, inverse: 1
- * https://www.nayuki.io/res/free-small-fft-in-multiple-languages/fft.c
+ * in-place transform of n = 2^levels points, n <= FFT_SIZE.
+ * computes the forward transform of (array[i][re] + j*array[i][im]);
+ * the inverse transform is obtained by swapping re and im.
+ *
+ * after the bit reversal permutation, radix-4 decimation-in-time stages are
+ * applied (preceded by one radix-2 stage if levels is odd). with binary bit
+ * reversed input, a block of 4 sub-transforms of length h holds the
+ * transforms of the input samples with index = 0, 2, 1, 3 (mod 4) in that
+ * order.
  */
-void fft(float array[][2], const uint8_t dir) {
-	const uint16_t n = FFT_SIZE;
-	const uint8_t levels = FFT_N; // log2(n)
-
-	const uint8_t real =   dir & 1;
-	const uint8_t imag = ~real & 1;
+template<class A>
+static void fft_radix4_core(typename A::T array[][2], const uint8_t re, const uint8_t im, const uint16_t n, const uint8_t levels) {
+	typedef typename A::T T;
+	const uint8_t shift = FFT_N - levels;
 	uint16_t i;
 
 	for (i = 0; i < n; i++) {
-		uint16_t j = reverse_bits(i, levels);
+		uint16_t j = fft_tables.bitrev[i] >> shift;
 		if (j > i) {
-			float temp = array[i][real];
-			array[i][real] = array[j][real];
-			array[j][real] = temp;
-			temp = array[i][imag];
-			array[i][imag] = array[j][imag];
-			array[j][imag] = temp;
+			T temp = array[i][re];
+			array[i][re] = array[j][re];
+			array[j][re] = temp;
+			temp = array[i][im];
+			array[i][im] = array[j][im];
+			array[j][im] = temp;
 		}
 	}
-	const uint16_t size = 2;
-	uint16_t halfsize = size / 2;
-	uint16_t tablestep = n / size;
-	uint16_t j, k;
-	// Cooley-Tukey decimation-in-time radix-2 FFT
-	for (;tablestep; tablestep>>=1, halfsize<<=1) {
-		for (i = 0; i < n; i+=2*halfsize) {
-			for (j = i, k = 0; j < i + halfsize; j++, k += tablestep) {
-				uint16_t l = j + halfsize;
-#ifdef FFT_USE_SIN_COS_TABLE
-				float s = SIN(k);
-				float c = COS(k);
+
+	uint16_t h = 1;
+	if (levels & 1) {
+		// radix-2 stage, no twiddles
+		for (i = 0; i < n; i += 2) {
+			T r = A::scale(array[i+1][re], 1), m = A::scale(array[i+1][im], 1);
+			T pr = A::scale(array[i][re], 1), pm = A::scale(array[i][im], 1);
+			array[i+1][re] = pr - r;
+			array[i+1][im] = pm - m;
+			array[i][re] = pr + r;
+			array[i][im] = pm + m;
+		}
+		h = 2;
+	}
+
+	// radix-4 stages
+	for (; h < n; h <<= 2) {
+		const uint16_t tablestep = FFT_SIZE / (4 * h);
+		for (i = 0; i < n; i += 4 * h) {
+			for (uint16_t k = 0, t = 0; k < h; k++, t += tablestep) {
+				const uint16_t j0 = i + k, j2 = j0 + h, j1 = j2 + h, j3 = j1 + h;
+				// t0 = F0, t1 = W^k F1, t2 = W^2k F2, t3 = W^3k F3, W = exp(-2*pi*j/(4h))
+				T t0r = A::scale(array[j0][re], 2), t0i = A::scale(array[j0][im], 2);
+				T t1r = A::scale(array[j1][re], 2), t1i = A::scale(array[j1][im], 2);
+				T t2r = A::scale(array[j2][re], 2), t2i = A::scale(array[j2][im], 2);
+				T t3r = A::scale(array[j3][re], 2), t3i = A::scale(array[j3][im], 2);
+				if (k != 0) {
+					T c, s, r;
+					c = A::cos(t); s = A::sin(t);
+					r   = A::mul(t1r, c) + A::mul(t1i, s);
+					t1i = A::mul(t1i, c) - A::mul(t1r, s);
+					t1r = r;
+					c = A::cos(2 * t); s = A::sin(2 * t);
+					r   = A::mul(t2r, c) + A::mul(t2i, s);
+					t2i = A::mul(t2i, c) - A::mul(t2r, s);
+					t2r = r;
+					c = A::cos(3 * t); s = A::sin(3 * t);
+					r   = A::mul(t3r, c) + A::mul(t3i, s);
+					t3i = A::mul(t3i, c) - A::mul(t3r, s);
+					t3r = r;
+				}
+				T a0r = t0r + t2r, a0i = t0i + t2i;
+				T a1r = t0r - t2r, a1i = t0i - t2i;
+				T b0r = t1r + t3r, b0i = t1i + t3i;
+				// -j * (t1 - t3)
+				T b1r = t1i - t3i, b1i = t3r - t1r;
+				array[j0][re] = a0r + b0r; array[j0][im] = a0i + b0i;
+				array[j1][re] = a0r - b0r; array[j1][im] = a0i - b0i;
+				array[j2][re] = a1r + b1r; array[j2][im] = a1i + b1i;
+				array[j3][re] = a1r - b1r; array[j3][im] = a1i - b1i;
+			}
+		}
+	}
+}
+
+#if FFT_FIXED_POINT
+/***
+ * without an FPU every float operation is a library call, so the float
+ * data is converted to q31 in place (block floating point: scaled by a
+ * power of 2 so that the largest component is below 2^30, which keeps the
+ * complex magnitude below 2^31), transformed in fixed point and converted
+ * back. the conversions are O(n) while the transform is O(n log n).
+ */
+static void fft_radix4(float array[][2], const uint8_t re, const uint8_t im, const uint16_t n, const uint8_t levels) {
+	int32_t (*q)[2] = (int32_t(*)[2])array;
+	float max = 0;
+	for (uint16_t i = 0; i < n; i++) {
+		float a = fabsf(array[i][0]), b = fabsf(array[i][1]);
+		if (a > max) max = a;
+		if (b > max) max = b;
+	}
+	if (max == 0)
+		return;
+	int exp;
+	frexpf(max, &exp);
+	// max < 2^exp
+	const int bits = 30 - exp;
+	for (uint16_t i = 0; i < n; i++) {
+		q[i][0] = (int32_t)ldexpf(array[i][0], bits);
+		q[i][1] = (int32_t)ldexpf(array[i][1], bits);
+	}
+	fft_radix4_core<fft_q31>(q, re, im, n, levels);
+	// the fixed point transform is divided by n = 2^levels
+	for (uint16_t i = 0; i < n; i++) {
+		array[i][0] = ldexpf((float)q[i][0], levels - bits);
+		array[i][1] = ldexpf((float)q[i][1], levels - bits);
+	}
+}
 #else
-				float c = cos(2 * VNA_PI * k / FFT_SIZE);
-				float s = sin(2 * VNA_PI * k / FFT_SIZE);
+static void fft_radix4(float array[][2], const uint8_t re, const uint8_t im, const uint16_t n, const uint8_t levels) {
+	fft_radix4_core<fft_float>(array, re, im, n, levels);
+}
 #endif
-				float tpre =  array[l][real] * c + array[l][imag] * s;
-				float tpim = -array[l][real] * s + array[l][imag] * c;
-				array[l][real] = array[j][real] - tpre;
-				array[l][imag] = array[j][imag] - tpim;
-				array[j][real] += tpre;
-				array[j][imag] += tpim;
-			}
+
+/***
+ * dir = forward: 0, inverse: 1
+ * the inverse transform is computed as a forward transform with real and
+ * imaginary parts swapped.
+ */
+void fft(float array[][2], const uint8_t dir) {
+	const uint8_t real =   dir & 1;
+	const uint8_t imag = ~real & 1;
+	fft_radix4(array, real, imag, FFT_SIZE, FFT_N);
+}
+
+/***
+ * inverse transform of a hermitian spectrum using a FFT_SIZE/2 point
+ * complex transform.
+ * even samples x[2m] and odd samples x[2m+1] of the output are the inverse
+ * transforms of E[k] = X[k] + X[k+N/2] and O[k] = (X[k] - X[k+N/2])*exp(2*pi*j*k/N),
+ * so the inverse transform of Z = E + j*O yields x[2m] + j*x[2m+1].
+ * X[k+N/2] = conj(X[N/2-k]) for a hermitian spectrum. the imaginary parts
+ * of X[0] and X[N/2] are ignored.
+ */
+void fft_inverse_real(float array[][2]) {
+	const uint16_t half = FFT_SIZE / 2;
+	array[0][1] = 0;
+	array[half][1] = 0;
+	for (uint16_t k = 0; k <= half / 2; k++) {
+		uint16_t k2 = half - k;
+		// a = X[k], b = conj(X[N/2-k])
+		float ar = array[k][0], ai = array[k][1];
+		float br = array[k2][0], bi = -array[k2][1];
+		float c = COS(k), s = SIN(k);
+		// Z[k] = (a + b) + j*(a - b)*exp(2*pi*j*k/N)
+		float dr = ar - br, di = ai - bi;
+		float or_ = dr * c - di * s, oi = dr * s + di * c;
+		float zr = ar + br - oi, zi = ai + bi + or_;
+		if (k2 != k && k2 < half) {
+			// Z[N/2-k]: a' = conj(b), b' = conj(a)
+			c = COS(k2); s = SIN(k2);
+			dr = br - ar; di = ai - bi;
+			or_ = dr * c - di * s; oi = dr * s + di * c;
+			array[k2][0] = br + ar - oi;
+			array[k2][1] = -bi - ai + or_;
+		}
+		array[k][0] = zr;
+		array[k][1] = zi;
+	}
+	fft_radix4(array, 1, 0, half, FFT_N - 1);
+}
+
+// generates exp(j*phi*i*i/2) for i = 0, 1, 2, ... by complex rotation:
+// c[i+1] = c[i] * d[i], d[i] = exp(j*phi*(2*i+1)/2), d[i+1] = d[i] * exp(j*phi)
+struct chirp_gen {
+	float cr = 1, ci = 0, dr, di, rr, ri;
+	chirp_gen(float phi) {
+		dr = cosf(phi / 2); di = sinf(phi / 2);
+		rr = cosf(phi); ri = sinf(phi);
+	}
+	void next() {
+		float t = cr * dr - ci * di;
+		ci = cr * di + ci * dr; cr = t;
+		t = dr * rr - di * ri;
+		di = dr * ri + di * rr; dr = t;
+	}
+};
+
+/***
+ * the chirp filter h[i] = exp(-j*phi*i*i/2), i = -(n-1) ... FFT_SIZE-n,
+ * stored circularly and transformed.
+ */
+void czt_prepare(float filter[][2], const uint16_t n, const float phi) {
+	const uint16_t block = FFT_SIZE - n + 1;
+	chirp_gen c(phi);
+	for (uint16_t i = 0; i < block || i < n; i++, c.next()) {
+		if (i < block) {
+			filter[i][0] = c.cr; filter[i][1] = -c.ci;
+		}
+		if (i > 0 && i < n) {
+			filter[FFT_SIZE - i][0] = c.cr; filter[FFT_SIZE - i][1] = -c.ci;
+		}
+	}
+	fft_radix4(filter, 0, 1, FFT_SIZE, FFT_N);
+}
+
+/***
+ * Bluestein's algorithm: using k*m = (k*k + m*m - (m-k)*(m-k))/2, the sum
+ * becomes a convolution of in[k]*exp(j*phi*k*k/2) with the chirp filter,
+ * computed by FFT. each FFT yields FFT_SIZE-n+1 outputs; outputs past
+ * that are computed in further blocks, each block starting at
+ * theta + m0*phi.
+ */
+void czt(const float in[][2], const float* weight, const uint16_t n,
+		float out[][2], const uint16_t count, const float theta, const float phi,
+		float work[][2], const float filter[][2]) {
+	const uint16_t block = FFT_SIZE - n + 1;
+	for (uint16_t m0 = 0; m0 < count; m0 += block) {
+		float start = fmodf(theta + m0 * phi, 2 * M_PI);
+		float sr = cosf(start), si = sinf(start);
+		// p = exp(j*start*k)
+		float pr = 1, pi = 0;
+		chirp_gen c(phi);
+		for (uint16_t k = 0; k < n; k++, c.next()) {
+			float w = weight ? weight[k] : 1.f;
+			float ar = in[k][0] * w, ai = in[k][1] * w;
+			float br = ar * pr - ai * pi, bi = ar * pi + ai * pr;
+			work[k][0] = br * c.cr - bi * c.ci;
+			work[k][1] = br * c.ci + bi * c.cr;
+			float t = pr * sr - pi * si;
+			pi = pr * si + pi * sr; pr = t;
+		}
+		for (uint16_t k = n; k < FFT_SIZE; k++) {
+			work[k][0] = 0; work[k][1] = 0;
+		}
+		fft_radix4(work, 0, 1, FFT_SIZE, FFT_N);
+		for (uint16_t k = 0; k < FFT_SIZE; k++) {
+			float ar = work[k][0], ai = work[k][1];
+			work[k][0] = ar * filter[k][0] - ai * filter[k][1];
+			work[k][1] = ar * filter[k][1] + ai * filter[k][0];
+		}
+		fft_radix4(work, 1, 0, FFT_SIZE, FFT_N);
+		chirp_gen d(phi);
+		const float scale = 1.f / FFT_SIZE;
+		for (uint16_t m = 0; m < block && m0 + m < count; m++, d.next()) {
+			float ar = work[m][0] * scale, ai = work[m][1] * scale;
+			out[m0 + m][0] = ar * d.cr - ai * d.ci;
+			out[m0 + m][1] = ar * d.ci + ai * d.cr;
 		}
 	}
 }
@@ -34,6 +34,14 @@
  */
 void fft(float array[][2], const uint8_t dir);
 
+/***
+ * inverse transform of a hermitian spectrum, with real output.
+ * input: array[0 ... FFT_SIZE/2] holds X[0 ... FFT_SIZE/2] (FFT_SIZE/2+1 points).
+ * output: (float*)array holds the FFT_SIZE real samples.
+ * the output is not normalized, same as fft_inverse().
+ */
+void fft_inverse_real(float array[][2]);
+
 static inline void fft_forward(float array[][2]) {
 	fft(array, 0);
 }
@@ -41,3 +49,17 @@ static inline void fft_forward(float array[][2]) {
 static inline void fft_inverse(float array[][2]) {
 	fft(array, 1);
 }
+
+/***
+ * chirp-z transform, evaluating the spectrum on an arbitrary grid:
+ *   out[m] = sum(k = 0 ... n-1) in[k] * weight[k] * exp(j*k*(theta + m*phi))
+ * for m = 0 ... count-1. weight may be NULL.
+ * filter must be prepared by czt_prepare() with the same n and phi and can
+ * be reused for any number of transforms. work and filter hold FFT_SIZE
+ * points each; n must be less than FFT_SIZE.
+ * the output is not normalized, same as fft_inverse().
+ */
+void czt_prepare(float filter[][2], const uint16_t n, const float phi);
+void czt(const float in[][2], const float* weight, const uint16_t n,
+		float out[][2], const uint16_t count, const float theta, const float phi,
+		float work[][2], const float filter[][2]);
@@ -34,6 +34,12 @@ complexf measured[2][SWEEP_POINTS_MAX] alignas(8);
 
 volatile EcalStates ecalState = ECAL_STATE_MEASURING;
 
+volatile int8_t calCollectProgress = -1;
+
+float td_zoom_start = 0, td_zoom_stop = 0;
+float td_gate_start = 0, td_gate_stop = 0;
+uint8_t td_gate_shape = TD_WINDOW_NORMAL;
+
 __attribute__((used))
 volatile int MEASUREMENT_NPERIODS_NORMAL = BOARD_MEASUREMENT_NPERIODS_NORMAL;
 __attribute__((used))
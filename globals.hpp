@@ -43,6 +43,51 @@ enum EcalStates {
 };
 extern volatile EcalStates ecalState;
 
+// percentage of points collected by the calibration collection in progress;
+// -1 if no collection is in progress.
+extern volatile int8_t calCollectProgress;
+
+// zoom and gating need a second FFT_SIZE buffer in ili9341_spi_buffers,
+// which only has room for it up to FFT_SIZE 256; without it they are off
+// and not offered in the menu.
+#define TD_SECOND_BUFFER (FFT_SIZE <= 256)
+
+// time span shown by the time domain transform, in seconds; the transform
+// covers its default span when td_zoom_stop <= td_zoom_start.
+extern float td_zoom_start, td_zoom_stop;
+
+static inline bool td_zoom_active() {
+  return TD_SECOND_BUFFER && td_zoom_stop > td_zoom_start;
+}
+
+// time gate applied to the frequency domain display, in seconds; gating
+// is off when td_gate_stop <= td_gate_start.
+// td_gate_shape is one of TD_WINDOW_MINIMUM, NORMAL or MAXIMUM.
+extern float td_gate_start, td_gate_stop;
+extern uint8_t td_gate_shape;
+
+static inline bool td_gate_active() {
+  return TD_SECOND_BUFFER && td_gate_stop > td_gate_start;
+}
+
+// settings the contents of measured[] depend on besides the sweep itself.
+struct td_key_t {
+  int16_t points;
+  uint8_t domainMode, kaiserBeta, chebyshevAtten, gateShape;
+  float zoomStart, zoomStop, gateStart, gateStop;
+  bool operator==(const td_key_t& other) const {
+    return points == other.points && domainMode == other.domainMode
+      && kaiserBeta == other.kaiserBeta && chebyshevAtten == other.chebyshevAtten
+      && gateShape == other.gateShape
+      && zoomStart == other.zoomStart && zoomStop == other.zoomStop
+      && gateStart == other.gateStart && gateStop == other.gateStop;
+  }
+};
+
+// the td_key_t of the current settings; all zero but points when
+// measured[] holds the frequency domain data unchanged.
+td_key_t td_key_current();
+
 extern uistat_t uistat;
 
 #define frequency0 current_props._frequency0
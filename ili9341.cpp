@@ -153,6 +153,8 @@ small_function<uint32_t(uint32_t sdi, int bits)> ili9341_spi_transfer;
 small_function<void(uint32_t words)> ili9341_spi_transfer_bulk;
 small_function<void()> ili9341_spi_wait_bulk;
 small_function<void(uint8_t *buf, uint32_t bytes)> ili9341_spi_read;
+void (*ili9341_write_tap)(int x, int y, int w, int h, const uint16_t *pixels, uint16_t color);
+uint32_t ili9341_pixels_written = 0;
 
 static inline void ssp_senddata(uint8_t x)
 {
@@ -169,8 +171,13 @@ static inline void ssp_senddata16(uint16_t x)
   ili9341_spi_transfer(x, 16);
 }
 
+// column window and next row of the last ili9341_bulk() while the panel is
+// still in that memory write; any other command ends it.
+static int bulk_x = -1, bulk_w, bulk_y;
+
 static void send_command(uint8_t cmd, int len, const uint8_t *data)
 {
+	bulk_x = -1;
 	CS_LOW;
 	DC_CMD;
 //    delayMicroseconds(1);
@@ -307,7 +314,8 @@ ili9341_init(void)
 }
 
 // Reverses the byte order within each halfword of a word. For example, 0x12345678 becomes 0x34127856.
-#if 0
+// the portable form is for the host tests
+#ifndef __arm__
 #define __REV16(v) (((((uint32_t)(v) & 0xFF000000) >> 8) | (((uint32_t)(v) & 0x00FF0000) << 8) | (((uint32_t)(v) & 0x0000FF00) >> 8) | (((uint32_t)(v) & 0x0000FF) << 8)))
 #else
 static inline uint32_t __REV16(uint32_t value)
@@ -335,6 +343,7 @@ void ili9341_pixel(int x, int y, uint16_t color)
 void ili9341_fill(int x, int y, int w, int h, uint16_t color)
 {
 	uint32_t len = w * h;
+	ili9341_pixels_written += len;
 	uint32_t xx = __REV16(x | ((x + w - 1) << 16));
 	uint32_t yy = __REV16(y | ((y + h - 1) << 16));
 	ili9341_spi_wait_bulk();
@@ -354,6 +363,8 @@ void ili9341_fill(int x, int y, int w, int h, uint16_t color)
 		ili9341_spi_transfer_bulk(bulk);
 		len -= bulk;
 	}
+	if(ili9341_write_tap)
+		ili9341_write_tap(x, y, w, h, NULL, color);
 	if(ili9341_spi_buffer == ili9341_spi_bufferA)
 		ili9341_spi_buffer = ili9341_spi_bufferB;
 	else ili9341_spi_buffer = ili9341_spi_bufferA;
@@ -362,14 +373,28 @@ void ili9341_fill(int x, int y, int w, int h, uint16_t color)
 void ili9341_bulk(int x, int y, int w, int h)
 {
 	uint32_t len = w * h;
-	uint32_t xx = __REV16(x | ((x + w - 1) << 16));
-	uint32_t yy = __REV16(y | ((y + h - 1) << 16));
+	ili9341_pixels_written += len;
 	ili9341_spi_wait_bulk();
-	send_command(ILI9341_COLUMN_ADDRESS_SET, 4, (uint8_t*)&xx);
-	send_command(ILI9341_PAGE_ADDRESS_SET, 4, (uint8_t*)&yy);
-	send_command(ILI9341_MEMORY_WRITE, 0, NULL);
+	if (x == bulk_x && w == bulk_w && y == bulk_y) {
+		// block right below the last one, e.g. the next cell of a column in
+		// draw_all_cells(): continue writing without setting the window
+		send_command(ILI9341_WRITE_MEMORY_CONTINUE, 0, NULL);
+	} else {
+		// the window extends to the bottom of the screen so that a following
+		// block below can continue it
+		uint32_t xx = __REV16(x | ((x + w - 1) << 16));
+		uint32_t yy = __REV16(y | ((LCD_HEIGHT - 1) << 16));
+		send_command(ILI9341_COLUMN_ADDRESS_SET, 4, (uint8_t*)&xx);
+		send_command(ILI9341_PAGE_ADDRESS_SET, 4, (uint8_t*)&yy);
+		send_command(ILI9341_MEMORY_WRITE, 0, NULL);
+	}
+	bulk_x = x;
+	bulk_w = w;
+	bulk_y = y + h;
 
 	ili9341_spi_transfer_bulk(len);
+	if(ili9341_write_tap)
+		ili9341_write_tap(x, y, w, h, ili9341_spi_buffer, 0);
 
 	// switch buffers so that the user can continue to render while
 	// the bulk transfer is happening.
@@ -461,30 +486,53 @@ ili9341_drawchar(uint8_t ch, int x, int y)
   ili9341_blitBitmap(x, y, FONT_GET_WIDTH(ch), FONT_GET_HEIGHT, FONT_GET_DATA(ch));
 }
 
+// draw the glyphs from str to end into the spi buffer and send them with
+// a single ili9341_bulk(), or one per buffer width for longer runs
+static void
+ili9341_drawglyphs(const char *str, const char *end, int x, int y)
+{
+  const int max_width = SPI_BUFFER_SIZE / FONT_GET_HEIGHT;
+  while (str < end) {
+    int w = 0;
+    const char *p = str;
+    while (p < end && w + FONT_GET_WIDTH((uint8_t)*p) <= max_width)
+      w += FONT_GET_WIDTH((uint8_t)*p++);
+    uint16_t *buf = ili9341_spi_buffer;
+    for (; str < p; str++) {
+      uint8_t ch = *str;
+      const uint8_t *char_buf = FONT_GET_DATA(ch);
+      uint16_t cw = FONT_GET_WIDTH(ch);
+      for (int c = 0; c < FONT_GET_HEIGHT; c++) {
+        uint8_t bits = char_buf[c];
+        uint16_t *out = &buf[c * w];
+        for (int r = 0; r < cw; r++, bits <<= 1)
+          out[r] = (0x80 & bits) ? foreground_color : background_color;
+      }
+      buf += cw;
+    }
+    ili9341_bulk(x, y, w, FONT_GET_HEIGHT);
+    x += w;
+  }
+}
+
 void ili9341_drawstring(const char *str, int x, int y)
 {
-  int x_pos = x;
   while (*str) {
-    uint8_t ch = *str++;
-    if (ch == '\n') {x = x_pos; y+=FONT_STR_HEIGHT; continue;}
-    const uint8_t *char_buf = FONT_GET_DATA(ch);
-    uint16_t w = FONT_GET_WIDTH(ch);
-    ili9341_blitBitmap(x, y, w, FONT_GET_HEIGHT, char_buf);
-    x += w;
+    const char *end = str;
+    while (*end && *end != '\n')
+      end++;
+    ili9341_drawglyphs(str, end, x, y);
+    if (*end == '\0')
+      break;
+    str = end + 1;
+    y += FONT_STR_HEIGHT;
   }
 }
 
 void
 ili9341_drawstring(const char *str, int len, int x, int y)
 {
-	const char* end = str + len;
-	while (str < end) {
-		uint8_t ch = *str++;
-		const uint8_t *char_buf = FONT_GET_DATA(ch);
-		uint16_t w = FONT_GET_WIDTH(ch);
-		ili9341_blitBitmap(x, y, w, FONT_GET_HEIGHT, char_buf);
-		x += w;
-	}
+	ili9341_drawglyphs(str, str + len, x, y);
 }
 
 int
@@ -63,6 +63,13 @@ extern small_function<void(uint8_t *buf, uint32_t bytes)> ili9341_spi_read;
 // wait for bulk transfers to complete
 extern small_function<void()> ili9341_spi_wait_bulk;
 
+// if set, called with each block written to the lcd once its transfer has
+// started; pixels is the w*h block, or NULL for a fill with color.
+extern void (*ili9341_write_tap)(int x, int y, int w, int h, const uint16_t *pixels, uint16_t color);
+
+// total pixels written to the lcd, for frame statistics
+extern uint32_t ili9341_pixels_written;
+
 
 static inline constexpr uint16_t byteReverse16(uint16_t x) {
     return (x << 8) | (x >> 8);
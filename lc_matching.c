@@ -112,15 +112,14 @@ static int lc_match_calc(int index)
 {
   const float R0 = lc_match_array.R0;
   // compute the impedance at the chosen frequency
-  const complexf coeff = measured[0][index];
-  const float RL = resistance(coeff);
-  const float XL = reactance(coeff);
+  const float RL = channel_value_at(0, TRC_R, index);
+  const float XL = channel_value_at(0, TRC_X, index);
 
   if (RL <= 0.5f)
     return -1;
 
   const float q_factor = XL / RL;
-  const float vswr = swr(coeff);
+  const float vswr = channel_value_at(0, TRC_SWR, index);
   // no need for any matching
   if (vswr <= 1.1f || q_factor >= 100.0f)
     return 0;
@@ -13,6 +13,7 @@ extern bool cpu_enable_fpu(void);
 namespace UIActions {
 
 	void cal_collect(int type);
+	void cal_collect_abort(void);
 	void cal_done(void);
 	void cal_reset(void);
 	void cal_reset_all(void);
@@ -49,6 +49,7 @@
 #include "stream_fifo.hpp"
 #include "sin_rom.hpp"
 #include "gain_cal.hpp"
+#include "stream_smoother.hpp"
 
 #ifdef HAS_SELF_TEST
 #include "self_test.hpp"
@@ -120,8 +121,13 @@ static freqHz_t currFreqHz = 0;		// current hardware tx frequency
 // this variable is decremented every time a data point arrives, if nonzero.
 static volatile int ecalIgnoreValues = 0;
 static volatile int collectMeasurementType = -1;
-static int collectMeasurementOffset = -1;
-static int collectMeasurementState = 0;
+// points of the UI sweep that have not been collected yet
+static uint32_t collectMeasurementPending[(SWEEP_POINTS_MAX + 31) / 32];
+static volatile int collectMeasurementRemaining = 0;
+// the data point in flight when collection starts is not used
+static volatile bool collectMeasurementSkip = false;
+// measurement time multiplier used while collecting each standard
+static uint8_t collectMeasurementAverage[CAL_THRU + 1] = {2, 2, 2, 2};
 static small_function<void()> collectMeasurementCB;
 
 static void adc_process();
@@ -561,6 +567,8 @@ static void lcd_and_ui_setup() {
 }
 
 static void enterUSBDataMode() {
+	// a collection in progress would store usb sweep points as UI ones
+	UIActions::cal_collect_abort();
 	usbDataMode = true;
 }
 static void exitUSBDataMode() {
@@ -572,13 +580,21 @@ static void exitUSBDataMode() {
 #define ecalApplyReflection(refl, freqIndex) refl
 #else
 complexf measuredEcal[ECAL_CHANNELS][USB_POINTS_MAX] alignas(8);
+
+// smooths the raw ecal values of the initial ecal sweep as they arrive;
+// equivalent to measurementDataSmooth(measuredEcal[ch], sweepPoints, 16)
+// after the sweep, without stalling the measurement callback at the end.
+static StreamSmoother<16> ecalSmoother[ECAL_CHANNELS];
+// next freqIndex expected by ecalSmoother
+static int ecalSmootherNext = 0;
+
 static complexf ecalApplyReflection(complexf refl, int freqIndex) {
 	#if defined(ECAL_PARTIAL)
 		return refl - measuredEcal[0][freqIndex];
 	#else
 		return SOL_compute_reflection(
 					measuredEcal[1][freqIndex],
-					1.f,
+					complexf(1.f),
 					measuredEcal[0][freqIndex],
 					refl);
 	#endif
@@ -667,6 +683,23 @@ For a description of the command interface see command_parser.hpp
 -- 40: adf4350 power
 -- 41: si5351 power (reserved)
 -- 42: average setting
+-- 44: calCollect: writing 0..3 (load, open, short, thru) collects that
+--     standard over the UI sweep, leaving usb data mode first;
+--     0xff aborts the collection in progress.
+-- 46: calCollectRemaining[7..0] - points left to collect, 0 when done
+-- 47: calCollectRemaining[15..8]
+-- 48: calCollectAverage[0] - averaging multiplier used for load
+-- 49: calCollectAverage[1] - open
+-- 4a: calCollectAverage[2] - short
+-- 4b: calCollectAverage[3] - thru
+-- e0: frameTimeUs[31..0] - time spent in the last draw_all() that drew anything
+-- e4: framePixels[31..0] - pixels written to the lcd in that frame
+-- e8: frameCells[15..0] - plot cells drawn in that frame
+-- ea: frameCount[15..0] - incremented after each such frame
+-- ee: capture: writing any value sends the screen, see cmdRegisterWrite
+-- ef: captureStream: 1 => start streaming screen updates, 0 => stop.
+--     while streaming, any other command ends the stream before it is
+--     handled, so that its reply follows the end of stream record.
 -- f0: device variant (01)
 -- f1: protocol version (01)
 -- f2: hardware revision
@@ -816,6 +849,27 @@ static void cmdReadFIFO(int address, int nValues) {
 	}
 }
 
+// draw_all() and record how long it took and how much was drawn in
+// registers e0 - eb; idle calls that draw nothing are not counted.
+static void captureFlush();
+
+static void drawFrame() {
+	uint32_t t0 = systemTimeCounter;
+	uint32_t pixels0 = ili9341_pixels_written;
+	plot_cells_drawn = 0;
+	draw_all(true);
+	uint32_t t = systemTimeCounter - t0;
+	uint32_t pixels = ili9341_pixels_written - pixels0;
+	// send the updates of this frame and of the ui since the last one
+	captureFlush();
+	if(pixels == 0)
+		return;
+	*(uint32_t*)(registers + 0xe0) = t;
+	*(uint32_t*)(registers + 0xe4) = pixels;
+	*(uint16_t*)(registers + 0xe8) = plot_cells_drawn;
+	*(uint16_t*)(registers + 0xea) += 1;
+}
+
 // apply usb-configured sweep parameters
 static void setVNASweepToUSB() {
 	int points = *(uint16_t*)(registers + 0x20);
@@ -847,7 +901,116 @@ static void setVNASweepToUSB() {
 	}
 #endif
 }
+// capture stream: instead of reading the lcd back, every block that is
+// written to it is sent to the host, which keeps its own copy of the screen.
+// starting the stream repaints the whole screen once; after that only the
+// parts that change are sent, while the sweep and ui keep running.
+// the stream starts with the same width, height, pixelFormat header as the
+// 0xee capture, followed by records of
+//   uint8_t type; uint16_t x, y, w, h;
+// type 1: a fill with the following pixel.
+// type 2: w*h pixels in rows, run length coded as a sequence of
+//   uint8_t n; n < 0x80: n+1 pixels follow; n >= 0x80: the following
+//   pixel repeats n-0x7e times.
+// type 0: end of stream, x, y, w and h are 0. sent when the host stops
+//   the stream or sends any other command.
+// pixels are rgb565 in the byte order of the 0xee capture.
+// records are buffered and sent when the buffer fills up and after each
+// frame, so that drawing does not wait for usb once per block.
+static bool captureStream = false;
+// holds a record header and the largest literal run
+static uint8_t captureBuffer[256 + 16];
+static int captureLen = 0;
+
+static void captureFlush() {
+	// a host that keeps up takes a buffer well within this; waiting longer
+	// would stall the display for a host that stopped reading
+	if(captureStream && captureLen > 0
+		&& !serialSendTimeout((char*) captureBuffer, captureLen, 10)) {
+		// host is gone
+		captureStream = false;
+		ili9341_write_tap = nullptr;
+	}
+	captureLen = 0;
+}
+
+static void capturePut(const void* data, int len) {
+	if(captureLen + len > (int) sizeof(captureBuffer))
+		captureFlush();
+	memcpy(captureBuffer + captureLen, data, len);
+	captureLen += len;
+}
+
+static void captureWrite(int x, int y, int w, int h, const uint16_t* pixels, uint16_t color) {
+#pragma pack(push, 1)
+	struct {
+		uint8_t type;
+		uint16_t x, y, w, h;
+	} rec = { uint8_t(pixels ? 2 : 1), uint16_t(x), uint16_t(y), uint16_t(w), uint16_t(h) };
+#pragma pack(pop)
+	capturePut(&rec, sizeof(rec));
+	if(!pixels) {
+		capturePut(&color, 2);
+		return;
+	}
+	int len = w * h;
+	for(int i = 0; i < len;) {
+		int run = 1;
+		while(i + run < len && run < 129 && pixels[i + run] == pixels[i])
+			run++;
+		if(run >= 2) {
+			uint8_t n = 0x7e + run;
+			capturePut(&n, 1);
+			capturePut(&pixels[i], 2);
+			i += run;
+			continue;
+		}
+		// literals up to the next run of 2
+		int lit = 1;
+		while(i + lit < len && lit < 128
+			&& !(i + lit + 1 < len && pixels[i + lit] == pixels[i + lit + 1]))
+			lit++;
+		uint8_t n = lit - 1;
+		capturePut(&n, 1);
+		capturePut(&pixels[i], lit * 2);
+		i += lit;
+	}
+}
+
+// send the end of stream record and stop streaming
+static void captureEnd() {
+	if(!captureStream)
+		return;
+	ili9341_write_tap = nullptr;
+	uint8_t rec[9] = {};
+	capturePut(rec, sizeof(rec));
+	captureFlush();
+	captureStream = false;
+}
+
 static void cmdRegisterWrite(int address) {
+	captureEnd();
+	if(address == 0xef) {
+		if(registers[0xef] == 0)
+			return;
+#pragma pack(push, 1)
+		constexpr struct {
+			uint16_t width;
+			uint16_t height;
+			uint8_t pixelFormat;
+		} meta = { LCD_WIDTH, LCD_HEIGHT, 16 };
+#pragma pack(pop)
+		captureLen = 0;
+		captureStream = true;
+		capturePut(&meta, sizeof(meta));
+		captureFlush();
+		if(!captureStream)
+			return;
+		ili9341_write_tap = captureWrite;
+		ui_redraw_screen();
+		captureFlush();
+		return;
+	}
 	if(address == 0xee) {
 		usbCaptureMode = true;
 #pragma pack(push, 1)
@@ -869,6 +1032,36 @@ static void cmdRegisterWrite(int address) {
 		usbCaptureMode = false;
 		return;
 	}
+	if (address == 0x44) {
+		// calibration collection with the UI sweep; the host polls 0x46
+		// until it reads 0 and may then start the next standard.
+		int type = registers[0x44];
+		if(type == 0xff)
+			UIActions::cal_collect_abort();
+		else if(!usbDataMode)
+			UIActions::cal_collect(type);
+		else if(type <= CAL_THRU) {
+			// collection stores points by UI sweep index, so it can not run
+			// on the usb sweep. leave usb data mode and start collecting
+			// from the event queue, which the main loop only runs after it
+			// has restored the UI sweep; until then 0x46 reads nonzero.
+			exitUSBDataMode();
+			int points = current_props._sweep_points;
+			registers[0x46] = uint8_t(points);
+			registers[0x47] = uint8_t(points >> 8);
+			UIActions::enqueueEvent([type]() {
+				if(!usbDataMode)
+					UIActions::cal_collect(type);
+				else
+					registers[0x46] = registers[0x47] = 0;
+			});
+		}
+		return;
+	}
+	if (address >= 0x48 && address <= 0x48 + CAL_THRU) {
+		collectMeasurementAverage[address - 0x48] = registers[address];
+		return;
+	}
 	if (address == 0x40) {UIActions::set_averaging(registers[0x40]); return;}
 	if (address == 0x42) {UIActions::set_adf4350_txPower(registers[0x42]); return;}
 
@@ -900,13 +1093,18 @@ static void cmdRegisterWrite(int address) {
 
 static void cmdInit() {
 	cmdParser.handleReadFIFO = [](int address, int nValues) {
+		captureEnd();
 		return cmdReadFIFO(address, nValues);
 	};
-	cmdParser.handleWriteFIFO = [](int address, int totalBytes, int nBytes, const uint8_t* data) {};
+	cmdParser.handleWriteFIFO = [](int address, int totalBytes, int nBytes, const uint8_t* data) {
+		captureEnd();
+	};
 	cmdParser.handleWrite = [](int address) {
 		return cmdRegisterWrite(address);
 	};
 	cmdParser.send = [](const uint8_t* s, int len) {
+		// register reads and the 0d query
+		captureEnd();
 		serialSendTimeout((char*) s, len, 1500);
 	};
 	cmdParser.registers = registers;
@@ -989,6 +1187,39 @@ static void measurementDataSmooth(complexf *data, int points, int count){
 		data[j] = (data[j] + data[j] + prev)/3.0f;
 	}
 }
+
+#ifndef BOARD_DISABLE_ECAL
+// feed raw ecal values (one per ecal channel) of the initial ecal sweep into
+// ecalSmoother; smoothed values are written back to measuredEcal.
+// returns true once a complete, contiguous sweep has been smoothed.
+static bool ecalSmoothPoint(int freqIndex, const complexf* values, int points) {
+	if(freqIndex == 0 || freqIndex != ecalSmootherNext) {
+		// restart at the beginning of a sweep
+		for(auto& smoother: ecalSmoother)
+			smoother.reset();
+		ecalSmootherNext = 0;
+		if(freqIndex != 0)
+			return false;
+	}
+	for(int ch = 0; ch < ECAL_CHANNELS; ch++) {
+		ecalSmoother[ch].push(values[ch], [ch](int i, complexf v) {
+			measuredEcal[ch][i] = v;
+		});
+	}
+	ecalSmootherNext = freqIndex + 1;
+	if(ecalSmootherNext < points)
+		return false;
+
+	for(int ch = 0; ch < ECAL_CHANNELS; ch++) {
+		ecalSmoother[ch].finish([ch](int i, complexf v) {
+			measuredEcal[ch][i] = v;
+		});
+	}
+	ecalSmootherNext = 0;
+	return true;
+}
+#endif
+
 int currDPCnt = 0;
 int lastFreqIndex = -1;
 VNAObservation currDP;
@@ -1051,7 +1282,27 @@ static void measurementEmitDataPoint(int freqIndex, freqHz_t freqHz, VNAObservat
 			measuredEcal[2][freqIndex] = ecal[2] * scale;
 #endif
 		} else {
-			if(ecalState == ECAL_STATE_DONE) {
+			if(ecalState == ECAL_STATE_MEASURING) {
+				complexf values[ECAL_CHANNELS];
+				values[0] = ecal0;
+				#ifndef ECAL_PARTIAL
+					values[1] = ecal[1] * scale;
+					values[2] = ecal[2] * scale;
+				#endif
+				// use the raw values until the smoothed ones are available
+				for(int ch = 0; ch < ECAL_CHANNELS; ch++)
+					measuredEcal[ch][freqIndex] = values[ch];
+				if(ecalSmoothPoint(freqIndex, values, vnaMeasurement.sweepPoints))
+					ecalState = ECAL_STATE_2NDSWEEP;
+			} else {
+				// drift of the ecal estimate, drives the adaptive ecal interval
+				complexf prev = measuredEcal[0][freqIndex];
+				float prevMag2 = prev.real()*prev.real() + prev.imag()*prev.imag();
+				if(ecalState == ECAL_STATE_DONE && prevMag2 > 0.f) {
+					complexf delta = ecal0 - prev;
+					float drift = (delta.real()*delta.real() + delta.imag()*delta.imag()) / prevMag2;
+					vnaMeasurement.ecalDriftUpdate(freqIndex, drift);
+				}
 				// Noise Filtering k = 0.8
 				measuredEcal[0][freqIndex] = measuredEcal[0][freqIndex] * 0.8f + ecal0 * 0.2f;
 				#ifndef ECAL_PARTIAL
@@ -1059,33 +1310,25 @@ static void measurementEmitDataPoint(int freqIndex, freqHz_t freqHz, VNAObservat
 					measuredEcal[1][freqIndex] = measuredEcal[1][freqIndex] * 0.8f + ecal[1] * scale;
 					measuredEcal[2][freqIndex] = measuredEcal[2][freqIndex] * 0.8f + ecal[2] * scale;
 				#endif
-			} else {
-				measuredEcal[0][freqIndex] = ecal0;
-				#ifndef ECAL_PARTIAL
-					measuredEcal[1][freqIndex] = ecal[1] * scale;
-					measuredEcal[2][freqIndex] = ecal[2] * scale;
-				#endif
-			}
-			if(ecalState == ECAL_STATE_MEASURING
-					&& freqIndex == vnaMeasurement.sweepPoints - 1) {
-				ecalState = ECAL_STATE_2NDSWEEP;
-			} else if(ecalState == ECAL_STATE_2NDSWEEP) {
-				ecalState = ECAL_STATE_DONE;
-				vnaMeasurement.ecalIntervalPoints = MEASUREMENT_ECAL_INTERVAL;
-				vnaMeasurement.measurement_mode = (enum MeasurementMode) current_props._measurement_mode;
-				measurementDataSmooth(measuredEcal[0], vnaMeasurement.sweepPoints, 16);
-				#ifndef ECAL_PARTIAL
-					measurementDataSmooth(measuredEcal[1], vnaMeasurement.sweepPoints, 16);
-					measurementDataSmooth(measuredEcal[2], vnaMeasurement.sweepPoints, 16);
-				#endif
+				if(ecalState == ECAL_STATE_2NDSWEEP) {
+					ecalState = ECAL_STATE_DONE;
+					vnaMeasurement.ecalIntervalReset();
+					vnaMeasurement.ecalIntervalPoints = MEASUREMENT_ECAL_INTERVAL;
+					vnaMeasurement.measurement_mode = (enum MeasurementMode) current_props._measurement_mode;
+				}
 			}
 		}
 	}
 #endif
 #endif
 
-	if(collectMeasurementType >= 0 && collectAllowed) {
+	if(collectMeasurementType >= 0 && collectAllowed && collectMeasurementSkip) {
+		collectMeasurementSkip = false;
+	} else if(collectMeasurementType >= 0 && collectAllowed
+			&& freqIndex < current_props._sweep_points
+			&& (collectMeasurementPending[freqIndex / 32] & (1u << (freqIndex % 32)))) {
 		// we are collecting a measurement for calibration
+		int points = current_props._sweep_points;
 
 		auto refl = ecalApplyReflection(v[0]/v[1], freqIndex);
 		current_props._cal_data[collectMeasurementType][freqIndex] = refl;
@@ -1099,31 +1342,44 @@ static void measurementEmitDataPoint(int freqIndex, freqHz_t freqHz, VNAObservat
 			current_props._cal_data[CAL_THRU_REFL][freqIndex] = refl;
 			current_props._cal_data[CAL_THRU][freqIndex] = tmp;
 		}
-		// Collect measure start from freqIndex, need collect all data
-		if(collectMeasurementState == 0) {
-			collectMeasurementState = 1;
-			collectMeasurementOffset = freqIndex > 0 ? freqIndex - 1 : vnaMeasurement.sweepPoints - 1;
-		} else if(collectMeasurementState == 1 && collectMeasurementOffset == freqIndex) {
-			collectMeasurementState = 0;
+		// every point is collected exactly once, starting from whichever
+		// point the sweep is at
+		collectMeasurementPending[freqIndex / 32] &= ~(1u << (freqIndex % 32));
+		int remaining = collectMeasurementRemaining - 1;
+		collectMeasurementRemaining = remaining;
+		registers[0x46] = uint8_t(remaining);
+		registers[0x47] = uint8_t(remaining >> 8);
+
+		int progress = (points - remaining) * 100 / points;
+		if(progress / 10 != calCollectProgress / 10) {
+			calCollectProgress = progress;
+			eventQueue.enqueue([]() {
+				draw_cal_status();
+			});
+		}
+		calCollectProgress = progress;
+
+		if(remaining == 0) {
 #if 0
 			// Made smooth result for calibration
 			int count = 4;
 			if(collectMeasurementType == CAL_LOAD)
-				measurementDataSmooth(current_props._cal_data[CAL_LOAD], vnaMeasurement.sweepPoints, count);
+				measurementDataSmooth(current_props._cal_data[CAL_LOAD], points, count);
 			else if(collectMeasurementType == CAL_OPEN){
-				measurementDataSmooth(current_props._cal_data[CAL_OPEN], vnaMeasurement.sweepPoints, count);
-				measurementDataSmooth(current_props._cal_data[CAL_ISOLN_OPEN], vnaMeasurement.sweepPoints, count*8);
+				measurementDataSmooth(current_props._cal_data[CAL_OPEN], points, count);
+				measurementDataSmooth(current_props._cal_data[CAL_ISOLN_OPEN], points, count*8);
 			}
 			else if(collectMeasurementType == CAL_SHORT){
-				measurementDataSmooth(current_props._cal_data[CAL_SHORT], vnaMeasurement.sweepPoints, count);
-				measurementDataSmooth(current_props._cal_data[CAL_ISOLN_SHORT], vnaMeasurement.sweepPoints, count*8);
+				measurementDataSmooth(current_props._cal_data[CAL_SHORT], points, count);
+				measurementDataSmooth(current_props._cal_data[CAL_ISOLN_SHORT], points, count*8);
 			}
 //			else if(collectMeasurementType == CAL_THRU) { // Not need smooth thru calibration, no noise,
-//				measurementDataSmooth(current_props._cal_data[CAL_THRU_REFL], vnaMeasurement.sweepPoints, count);
-//				measurementDataSmooth(current_props._cal_data[CAL_THRU], vnaMeasurement.sweepPoints, count);
+//				measurementDataSmooth(current_props._cal_data[CAL_THRU_REFL], points, count);
+//				measurementDataSmooth(current_props._cal_data[CAL_THRU], points, count);
 //			}
 #endif
 			collectMeasurementType = -1;
+			calCollectProgress = -1;
 			eventQueue.enqueue(collectMeasurementCB);
 		}
 	}
@@ -1271,14 +1527,293 @@ static float kaiser_window(float k, float n, float beta) {
 	return bessel0(beta * sqrt(1 - r * r)) / bessel0(beta);
 }
 
+// generalized cosine window: sum of a[j] * cos(2*pi*j*k/(n-1)) with
+// alternating signs
+template<int terms>
+static float cosine_window(float k, float n, const float (&a)[terms]) {
+	float x = 2 * M_PI * k / (n - 1);
+	float ret = 0, sign = 1;
+	for (int j = 0; j < terms; j++, sign = -sign)
+		ret += sign * a[j] * cos(j * x);
+	return ret;
+}
+
+// chebyshev polynomial of order n, for any x
+static float chebyshev_poly(int n, float x) {
+	if (fabs(x) <= 1)
+		return cos(n * acos(x));
+	float ret = cosh(n * acosh(fabs(x)));
+	return (x < 0 && (n & 1)) ? -ret : ret;
+}
+
+// Dolph-Chebyshev window of length n with sidelobes atten dB below the
+// main lobe; writes samples [offset, offset + count) to out.
+// the window is the inverse DFT of the chebyshev polynomial sampled on the
+// unit circle; the inner loop rotates a phasor instead of calling cos().
+static void chebyshev_window(float* out, int offset, int count, int n, float atten) {
+	int order = n - 1;
+	float x0 = cosh(acosh(pow(10.f, atten / 20.f)) / order);
+	float center = order * 0.5f;
+	for (int i = 0; i < count; i++)
+		out[i] = 0;
+	for (int m = 0; m < n; m++) {
+		float a = chebyshev_poly(order, x0 * cos(M_PI * m / n));
+		float w = 2 * M_PI * m / n;
+		complexf rot = polar(1.f, w);
+		complexf ph = polar(a, w * (offset - center));
+		for (int i = 0; i < count; i++) {
+			out[i] += ph.real();
+			ph *= rot;
+		}
+	}
+	float peak = 0;
+	for (int i = 0; i < count; i++)
+		if (out[i] > peak) peak = out[i];
+	for (int i = 0; i < count; i++)
+		out[i] /= peak;
+}
+
+// kaiser window beta of TD_WINDOW_MINIMUM, NORMAL and MAXIMUM
+static float td_window_beta(uint8_t window) {
+	switch (window) {
+		case TD_WINDOW_NORMAL:
+			return 6.0;
+		case TD_WINDOW_MAXIMUM:
+			return 13;
+	}
+	return 0.0; // this is rectangular
+}
+
+// window coefficients used by transform_domain(); only recomputed when
+// the sweep length, window placement or window settings change.
+static float td_window[SWEEP_POINTS_MAX];
+static struct {
+	int16_t points = -1, offset, windowSize;
+	uint8_t mode, kaiserBeta, chebyshevAtten;
+} td_window_key;
+
+// computes the window for all points of the sweep
+static void td_window_update(int points, int offset, int window_size) {
+	int count = points;
+	uint8_t mode = domain_mode & (TD_WINDOW | TD_WINDOW_TYPE);
+	uint8_t kaiserBeta = current_props._td_kaiser_beta;
+	uint8_t chebyshevAtten = current_props._td_chebyshev_atten;
+	if (td_window_key.points == points && td_window_key.offset == offset
+		&& td_window_key.windowSize == window_size && td_window_key.mode == mode
+		&& td_window_key.kaiserBeta == kaiserBeta
+		&& td_window_key.chebyshevAtten == chebyshevAtten)
+		return;
+	td_window_key.points = points;
+	td_window_key.offset = offset;
+	td_window_key.windowSize = window_size;
+	td_window_key.mode = mode;
+	td_window_key.kaiserBeta = kaiserBeta;
+	td_window_key.chebyshevAtten = chebyshevAtten;
+
+	static const float hann[] = {0.5f, 0.5f};
+	static const float blackmanHarris[] = {0.35875f, 0.48829f, 0.14128f, 0.01168f};
+	float beta = 0.0;
+	switch (mode) {
+		case TD_WINDOW_MINIMUM:
+		case TD_WINDOW_NORMAL:
+		case TD_WINDOW_MAXIMUM:
+			beta = td_window_beta(mode);
+			break;
+		case TD_WINDOW_KAISER:
+			beta = kaiserBeta / 10.f;
+			break;
+		case TD_WINDOW_HANN:
+			for (int i = 0; i < count; i++)
+				td_window[i] = cosine_window(i + offset, window_size, hann);
+			return;
+		case TD_WINDOW_BLACKMAN_HARRIS:
+			for (int i = 0; i < count; i++)
+				td_window[i] = cosine_window(i + offset, window_size, blackmanHarris);
+			return;
+		case TD_WINDOW_CHEBYSHEV:
+			chebyshev_window(td_window, offset, count, window_size,
+				chebyshevAtten >= 20 ? chebyshevAtten : 80);
+			return;
+	}
+	for (int i = 0; i < count; i++)
+		td_window[i] = kaiser_window(i + offset, window_size, beta);
+}
+
+// zoom and gating need a second FFT_SIZE buffer: for the chirp filter and
+// the gate normalization respectively
+static constexpr bool td_second_buffer = TD_SECOND_BUFFER;
+static_assert(!td_second_buffer || 2*FFT_SIZE*sizeof(complexf) <= sizeof(ili9341_spi_buffers));
+
+// time domain response on the td_zoom_start ... td_zoom_stop grid, using
+// the chirp-z transform. the time scale is the same as the FFT path,
+// where output index i is at time i / (FFT_SIZE * step frequency), and all
+// points of the sweep are used.
+static void transform_domain_zoom(int points, bool is_lowpass, uint8_t channels) {
+	float (*work)[2] = (float(*)[2])ili9341_spi_buffers;
+	float (*filter)[2] = work + FFT_SIZE;
+
+	float df = float(UIActions::frequencyAt(1) - UIActions::frequencyAt(0));
+	float dt = (td_zoom_stop - td_zoom_start) / (points - 1);
+	float theta = 2 * M_PI * df * td_zoom_start;
+	float phi = 2 * M_PI * df * dt;
+	czt_prepare(filter, points, phi);
+
+	for (int ch = 0; ch < 2; ch++) {
+		if (!(channels & (1 << ch)))
+			continue;
+		float (*in)[2] = (float(*)[2])measuredFreqDomain[ch];
+		float (*out)[2] = (float(*)[2])measured[ch];
+		czt(in, td_window, points, out, points, theta, phi, work, filter);
+		if (!is_lowpass) {
+			for (int i = 0; i < points; i++)
+				measured[ch][i] /= (float)FFT_SIZE;
+			continue;
+		}
+		// hermitian spectrum: x(t) = X[0] + 2*Re(sum(k = 1 ... ) X[k]*...)
+		float dc = measuredFreqDomain[ch][0].real() * td_window[0];
+		for (int i = 0; i < points; i++)
+			measured[ch][i] = {(2 * measured[ch][i].real() - dc) / (float)FFT_SIZE, 0.f};
+
+		if ((domain_mode & TD_FUNC) == TD_FUNC_LOWPASS_STEP) {
+			// the FFT path sums the impulse response over output indexes;
+			// the value at td_zoom_start is that sum in closed form
+			// (geometric series per frequency), from which the zoomed
+			// impulse response is integrated.
+			float u = td_zoom_start * df * FFT_SIZE;
+			float du = dt * df * FFT_SIZE;
+			float sum = dc * (u + 1);
+			for (int k = 1; k < points; k++) {
+				float a = 2 * M_PI * k / FFT_SIZE;
+				complexf num = 1.f - polar(1.f, fmodf(a * (u + 1), 2 * M_PI));
+				complexf den = 1.f - polar(1.f, a);
+				sum += 2 * (measuredFreqDomain[ch][k] * td_window[k] * num / den).real();
+			}
+			float prev = measured[ch][0].real();
+			measured[ch][0] = {sum / (float)FFT_SIZE, 0.f};
+			for (int i = 1; i < points; i++) {
+				float cur = measured[ch][i].real();
+				float step = (prev + cur) * 0.5f * du;
+				measured[ch][i] = {measured[ch][i-1].real() + step, 0.f};
+				prev = cur;
+			}
+		}
+	}
+}
+
+// time gating of the frequency domain data: the sweep is transformed to
+// time domain (bandpass), multiplied by a kaiser window spanning
+// td_gate_start ... td_gate_stop and transformed back. the result is
+// divided by the transform of the frequency domain window alone gated by
+// the same gate moved to t = 0. this undoes the window and corrects the
+// roll-off the gate causes near the ends of the sweep, exactly for a
+// response at the gate center.
+static void gate_domain(int points, uint8_t channels) {
+	complexf* buf = (complexf*)ili9341_spi_buffers;
+	complexf* norm = buf + FFT_SIZE;
+
+	float df = float(UIActions::frequencyAt(1) - UIActions::frequencyAt(0));
+	// gate edges in units of FFT bins
+	float g0 = td_gate_start * df * FFT_SIZE;
+	float g1 = td_gate_stop * df * FFT_SIZE;
+	float beta = td_window_beta(td_gate_shape);
+	td_window_update(points, 0, points);
+
+	// ch = -1 computes the normalization
+	for (int ch = -1; ch < 2; ch++) {
+		if (ch >= 0 && !(channels & (1 << ch)))
+			continue;
+		float shift = ch < 0 ? (g0 + g1) * 0.5f : 0.f;
+		for (int i = 0; i < points; i++)
+			buf[i] = (ch < 0 ? complexf(1.f) : measuredFreqDomain[ch][i]) * td_window[i];
+		for (int i = points; i < FFT_SIZE; i++)
+			buf[i] = 0.f;
+		fft_inverse((float(*)[2])buf);
+		for (int i = 0; i < FFT_SIZE; i++) {
+			// the second half of the transform is negative time
+			float t = i < FFT_SIZE/2 ? i : i - FFT_SIZE;
+			t += shift;
+			if (t < g0 || t > g1)
+				buf[i] = 0.f;
+			else
+				buf[i] *= kaiser_window(t - g0, g1 - g0 + 1, beta);
+		}
+		fft_forward((float(*)[2])buf);
+		if (ch < 0) {
+			memcpy(norm, buf, points * sizeof(complexf));
+			continue;
+		}
+		// points the window or gate suppress almost completely are left ungated
+		const float minNorm = 1e-3f * FFT_SIZE;
+		for (int i = 0; i < points; i++) {
+			if (std::norm(norm[i]) > minNorm * minNorm)
+				measured[ch][i] = buf[i] / norm[i];
+			else
+				measured[ch][i] = measuredFreqDomain[ch][i];
+		}
+	}
+}
+
+static td_key_t td_key;
+// channels of measured[] that hold the transform of the current
+// measuredFreqDomain[] with the settings in td_key
+static uint8_t td_valid_channels = 0;
+
+// called when measuredFreqDomain[] has been updated
+static void transform_domain_invalidate() {
+	td_valid_channels = 0;
+}
+
+// channels used by enabled traces
+static uint8_t td_used_channels() {
+	uint8_t ret = 0;
+	for (int t = 0; t < TRACES_MAX; t++)
+		if (trace[t].enabled)
+			ret |= 1 << trace[t].channel;
+	return ret;
+}
+
+td_key_t td_key_current() {
+	td_key_t key = {current_props._sweep_points};
+	if ((domain_mode & DOMAIN_MODE) != DOMAIN_TIME && !td_gate_active())
+		return key;
+	key.domainMode = domain_mode & (DOMAIN_MODE | TD_FUNC | TD_WINDOW | TD_WINDOW_TYPE);
+	key.kaiserBeta = current_props._td_kaiser_beta;
+	key.chebyshevAtten = current_props._td_chebyshev_atten;
+	key.gateShape = td_gate_shape;
+	key.zoomStart = td_zoom_start;
+	key.zoomStop = td_zoom_stop;
+	key.gateStart = td_gate_start;
+	key.gateStop = td_gate_stop;
+	return key;
+}
+
+// transforms the channels used by enabled traces that are not up to date
 static void transform_domain() {
-	if ((domain_mode & DOMAIN_MODE) != DOMAIN_TIME) return; // nothing to do for freq domain
+	bool gating = td_gate_active();
+	if ((domain_mode & DOMAIN_MODE) != DOMAIN_TIME && !gating)
+		return; // nothing to do for freq domain
+
+	td_key_t key = td_key_current();
+	if (!(key == td_key)) {
+		td_key = key;
+		td_valid_channels = 0;
+	}
+	uint8_t channels = td_used_channels() & ~td_valid_channels;
+	if (channels == 0)
+		return;
+	td_valid_channels |= channels;
+
+	if ((domain_mode & DOMAIN_MODE) != DOMAIN_TIME) {
+		gate_domain(current_props._sweep_points, channels);
+		return;
+	}
 	// use spi_buffer as temporary buffer
 	// and calculate ifft for time domain
 	float* tmp = (float*)ili9341_spi_buffers;
 
-	// lowpass uses 2x sweep_points of input buffer space
-	static_assert((sizeof(measuredFreqDomain[0]) * 2) <= sizeof(ili9341_spi_buffers));
+	// bandpass uses FFT_SIZE complex points of buffer space,
+	// lowpass FFT_SIZE/2+1 (real output transform)
+	static_assert(sizeof(measuredFreqDomain[0]) <= sizeof(ili9341_spi_buffers));
 	static_assert(FFT_SIZE*sizeof(float)*2 <= sizeof(ili9341_spi_buffers));
 
 	int points = current_props._sweep_points;
@@ -1296,51 +1831,47 @@ static void transform_domain() {
 			window_size = points * 2;
 			break;
 	}
+	bool is_step = (domain_mode & TD_FUNC) == TD_FUNC_LOWPASS_STEP;
 
-	float beta = 0.0;
-	switch (domain_mode & TD_WINDOW) {
-		case TD_WINDOW_MINIMUM:
-			beta = 0.0; // this is rectangular
-			break;
-		case TD_WINDOW_NORMAL:
-			beta = 6.0;
-			break;
-		case TD_WINDOW_MAXIMUM:
-			beta = 13;
-			break;
+	td_window_update(points, offset, window_size);
+	if (td_zoom_active()) {
+		transform_domain_zoom(points, is_lowpass, channels);
+		return;
 	}
 
+	// lowpass: the spectrum is hermitian, only X[0 ... FFT_SIZE/2] is used
+	int fft_points = is_lowpass ? FFT_SIZE/2 + 1 : FFT_SIZE;
+	int in_points = points < fft_points ? points : fft_points;
 
 	for (int ch = 0; ch < 2; ch++) {
-		memcpy(tmp, measuredFreqDomain[ch], sizeof(measuredFreqDomain[0]));
-		for (int i = 0; i < points; i++) {
-			float w = kaiser_window(i+offset, window_size, beta);
-			tmp[i*2+0] *= w;
-			tmp[i*2+1] *= w;
+		if (!(channels & (1 << ch)))
+			continue;
+		const float* in = (const float*)measuredFreqDomain[ch];
+		for (int i = 0; i < in_points; i++) {
+			float w = td_window[i];
+			tmp[i*2+0] = in[i*2+0] * w;
+			tmp[i*2+1] = in[i*2+1] * w;
 		}
-		for (int i = points; i < FFT_SIZE; i++) {
+		for (int i = in_points; i < fft_points; i++) {
 			tmp[i*2+0] = 0.0;
 			tmp[i*2+1] = 0.0;
 		}
-		if (is_lowpass) {
-			for (int i = 1; i < points; i++) {
-				tmp[(FFT_SIZE-i)*2+0] =  tmp[i*2+0];
-				tmp[(FFT_SIZE-i)*2+1] = -tmp[i*2+1];
-			}
-		}
 
-		fft_inverse((float(*)[2])tmp);
-		memcpy(measured[ch], tmp, sizeof(measured[0]));
-		for (int i = 0; i < points; i++) {
-			measured[ch][i] /= (float)FFT_SIZE;
-			if (is_lowpass) {
-				measured[ch][i] = {measured[ch][i].real(), 0.f};
-			}
-		}
-		if ( (domain_mode & TD_FUNC) == TD_FUNC_LOWPASS_STEP ) {
-			for (int i = 1; i < points; i++) {
-				measured[ch][i] += measured[ch][i-1];
+		// normalize and extract the output in one pass; the step
+		// response is the running sum of the impulse response.
+		const float scale = 1.f / FFT_SIZE;
+		if (is_lowpass) {
+			fft_inverse_real((float(*)[2])tmp);
+			float sum = 0;
+			for (int i = 0; i < points; i++) {
+				float v = tmp[i] * scale;
+				sum += v;
+				measured[ch][i] = {is_step ? sum : v, 0.f};
 			}
+		} else {
+			fft_inverse((float(*)[2])tmp);
+			for (int i = 0; i < points; i++)
+				measured[ch][i] = {tmp[i*2+0] * scale, tmp[i*2+1] * scale};
 		}
 	}
 }
@@ -1353,6 +1884,63 @@ static void apply_edelay(int i, complexf& refl, complexf& thru) {
 	thru *= s;
 }
 
+// RAM cache of calibration data interpolated from a save slot onto a
+// different frequency grid, so that switching back to a grid seen recently
+// does not need to interpolate again. the number of entries follows from
+// CALCACHE_RAM, the bytes set aside for it; each entry takes about
+// sizeof(properties_t::_cal_data), 11 KB at 201 points.
+// no board has that much RAM to spare, so the cache is off unless a build
+// sets CALCACHE_RAM, e.g. EXTRA_CFLAGS=-DCALCACHE_RAM=24576 for two entries.
+#define CALCACHE_ENTRY_BYTES (CAL_ENTRIES * SWEEP_POINTS_MAX * 8 + 32)
+#ifndef CALCACHE_RAM
+#define CALCACHE_RAM 0
+#endif
+#ifndef CALCACHE_ENTRIES
+#define CALCACHE_ENTRIES (CALCACHE_RAM / CALCACHE_ENTRY_BYTES)
+#endif
+
+#if CALCACHE_ENTRIES > 0
+struct calCacheEntry {
+  int16_t slot;		// save slot id + 1, 0 if the entry is unused
+  int16_t points;
+  freqHz_t start, step;
+  uint16_t status;
+  complexf data[CAL_ENTRIES][SWEEP_POINTS_MAX];
+};
+static_assert(sizeof(calCacheEntry) <= CALCACHE_ENTRY_BYTES);
+static calCacheEntry calCache[CALCACHE_ENTRIES];
+// next entry to be replaced
+static int calCacheNext = 0;
+
+// drop all entries derived from save slot id
+static void calCacheInvalidate(int id) {
+  for (auto& e: calCache)
+    if (e.slot == id + 1)
+      e.slot = 0;
+}
+
+static calCacheEntry* calCacheFind(int id, freqHz_t start, freqHz_t step, int points) {
+  for (auto& e: calCache)
+    if (e.slot == id + 1 && e.start == start && e.step == step && e.points == points)
+      return &e;
+  return nullptr;
+}
+
+static void calCacheStore(int id, freqHz_t start, freqHz_t step, int points) {
+  calCacheEntry& e = calCache[calCacheNext];
+  if (++calCacheNext >= CALCACHE_ENTRIES)
+    calCacheNext = 0;
+  e.slot = id + 1;
+  e.start = start;
+  e.step = step;
+  e.points = points;
+  e.status = cal_status;
+  memcpy(e.data, current_props._cal_data, sizeof(e.data));
+}
+#else
+static inline void calCacheInvalidate(int id) {}
+#endif
+
 void
 cal_interpolate(void)
 {
@@ -1377,6 +1965,15 @@ cal_interpolate(void)
     redraw_request |= REDRAW_CAL_STATUS;
     return;
   }
+#if CALCACHE_ENTRIES > 0
+  calCacheEntry* cached = calCacheFind(lastsaveid, dst_start, dst_step, sweep_points);
+  if (cached != nullptr) {
+    memcpy(current_props._cal_data, cached->data, sizeof(cached->data));
+    cal_status |= cached->status & ~CALSTAT_APPLY;
+    redraw_request |= REDRAW_CAL_STATUS;
+    return;
+  }
+#endif
   // lower than start freq of src range
   for (i = 0; i < sweep_points; i++) {
     freqHz_t dst_f = dst_start + i*dst_step;
@@ -1418,6 +2015,9 @@ cal_interpolate(void)
   }
   cal_status |= (src->_cal_status | CALSTAT_INTERPOLATED)&~CALSTAT_APPLY;
   redraw_request |= REDRAW_CAL_STATUS;
+#if CALCACHE_ENTRIES > 0
+  calCacheStore(lastsaveid, dst_start, dst_step, sweep_points);
+#endif
 }
 
 
@@ -1439,65 +2039,33 @@ static bool processDataPoint() {
 
 		refl = ecalApplyReflection(refl, freqIndex);
 		if(current_props._cal_status & CALSTAT_APPLY) {
-			// apply thru leakage correction
-			auto x1 = current_props._cal_data[CAL_SHORT][freqIndex],
-				y1 = current_props._cal_data[CAL_ISOLN_SHORT][freqIndex],
-				x2 = current_props._cal_data[CAL_OPEN][freqIndex],
-				y2 = current_props._cal_data[CAL_ISOLN_OPEN][freqIndex];
-			auto cal_thru_leak_r = (y1-y2)/(x1-x2);
-			auto cal_thru_leak = y2-cal_thru_leak_r*x2;
-			thru = thru - (cal_thru_leak + refl*cal_thru_leak_r);
-
-			// calculate reflection
-			auto newRefl = SOL_compute_reflection(
-						current_props._cal_data[CAL_SHORT][freqIndex],
-						current_props._cal_data[CAL_OPEN][freqIndex],
-						current_props._cal_data[CAL_LOAD][freqIndex],
-						refl);
-
-			// apply thru response correction
-			if(current_props._cal_status & CALSTAT_THRU) {
-				auto refThru = current_props._cal_data[CAL_THRU][freqIndex];
-				auto reflThru = current_props._cal_data[CAL_THRU_REFL][freqIndex];
-				refThru = refThru - (cal_thru_leak + reflThru*cal_thru_leak_r);
-				reflThru = SOL_compute_reflection(
-						current_props._cal_data[CAL_SHORT][freqIndex],
-						current_props._cal_data[CAL_OPEN][freqIndex],
-						current_props._cal_data[CAL_LOAD][freqIndex],
-						reflThru);
-				auto thruGain = SOL_compute_thru_gain(
-						current_props._cal_data[CAL_SHORT][freqIndex],
-						current_props._cal_data[CAL_OPEN][freqIndex],
-						current_props._cal_data[CAL_LOAD][freqIndex],
-						newRefl);
-				
-				auto refThruGain = SOL_compute_thru_gain(
-						current_props._cal_data[CAL_SHORT][freqIndex],
-						current_props._cal_data[CAL_OPEN][freqIndex],
-						current_props._cal_data[CAL_LOAD][freqIndex],
-						reflThru);
-
-				if(cal_status & CALSTAT_ENHANCED_RESPONSE)
-					refThru *= thruGain / refThruGain;
-
-				thru = thru / refThru;
-			}
-
-			refl = newRefl;
+			array<complexf, CAL_ENTRIES> cal;
+			for(int eterm = 0; eterm < CAL_ENTRIES; eterm++)
+				cal[eterm] = current_props._cal_data[eterm][freqIndex];
+			SOLT_apply_correction(cal,
+						(current_props._cal_status & CALSTAT_THRU) != 0,
+						(current_props._cal_status & CALSTAT_ENHANCED_RESPONSE) != 0,
+						refl, thru);
 		}
 		apply_edelay(usbDP.freqIndex, refl, thru);
 		measuredFreqDomain[0][usbDP.freqIndex] = refl;
 		measuredFreqDomain[1][usbDP.freqIndex] = thru;
-		if ((domain_mode & DOMAIN_MODE) == DOMAIN_FREQ) {
+		// with gating, measured[] is written at the end of the sweep
+		if ((domain_mode & DOMAIN_MODE) == DOMAIN_FREQ && !td_gate_active()) {
 			measured[0][usbDP.freqIndex] = refl;
 			measured[1][usbDP.freqIndex] = thru;
+			plot_points_changed(freqIndex, freqIndex);
 		}
 
 		rdRPos = (rdRPos + 1) & usbTxQueueMask;
 		usbTxQueueRPos = rdRPos;
 
 		if(freqIndex == vnaMeasurement.sweepPoints - 1) {
+			transform_domain_invalidate();
 			transform_domain();
+			// gating writes all of measured[] at the end of the sweep
+			if ((domain_mode & DOMAIN_MODE) == DOMAIN_FREQ && td_gate_active())
+				plot_points_changed(0, freqIndex);
 			return true;
 		}
 	}
@@ -1584,6 +2152,12 @@ int main(void) {
 	registers[0x40] = current_props._avg;
 	registers[0x41] = current_props._si5351_txPower;
 	registers[0x42] = current_props._adf4350_txPower;
+	//	-- 44: start calibration collection of standard (CAL_LOAD/OPEN/SHORT/THRU); 0xff aborts
+	//	-- 46-47: number of points remaining in the calibration collection
+	//	-- 48-4b: calibration collection averaging for LOAD, OPEN, SHORT, THRU
+	registers[0x44] = 0xff;
+	for(int i = 0; i <= CAL_THRU; i++)
+		registers[0x48 + i] = collectMeasurementAverage[i];
 
 	// we want all higher priority irqs to preempt lower priority ones
 	scb_set_priority_grouping(SCB_AIRCR_PRIGROUP_GROUP16_NOSUB);
@@ -1759,10 +2333,11 @@ int main(void) {
 		if(sweep_enabled) {
 			if(processDataPoint()) {
 				// a full sweep has completed
+				sweep_count++;
 				if ((domain_mode & DOMAIN_MODE) == DOMAIN_TIME) {
 					plot_into_index(measured);
 					ui_marker_track();
-					if(!lcdInhibit) draw_all(true);
+					if(!lcdInhibit) drawFrame();
 					continue;
 				}
 			}
@@ -1772,11 +2347,11 @@ int main(void) {
 		if(!eventQueue.readable()) {
 			if(sweep_enabled) {
 				if((domain_mode & DOMAIN_MODE) == DOMAIN_FREQ) {
-					plot_into_index(measured);
+					plot_into_index_changed(measured);
 					ui_marker_track();
 				}
 			}
-			if(!lcdInhibit) draw_all(true);
+			if(!lcdInhibit) drawFrame();
 			continue;
 		}
 		auto callback = eventQueue.read();
@@ -1868,6 +2443,9 @@ extern "C" {
 namespace UIActions {
 
 	void cal_collect(int type) {
+		if(type < 0 || type > CAL_THRU)
+			return;
+		collectMeasurementType = -1;
 		current_props._cal_status &= ~(1 << type);
 		vnaMeasurement.measurement_mode = MEASURE_MODE_FULL;
 		collectMeasurementCB = [type]() {
@@ -1881,7 +2459,9 @@ namespace UIActions {
 			current_props._cal_status |= (1 << type);
 			ui_cal_collected();
 		};
-		uint32_t avgMult = 2;
+		uint32_t avgMult = collectMeasurementAverage[type];
+		if(avgMult < 1)
+			avgMult = 1;
 	#if BOARD_REVISION >= 4
 		__sync_synchronize();
 		sys_setTimings_args args {0, avgMult};
@@ -1889,10 +2469,38 @@ namespace UIActions {
 	#else
 		vnaMeasurement.ecalIntervalPoints = 1;
 		vnaMeasurement.nPeriodsMultiplier = avgMult;
-		vnaMeasurement.resetSweep();
 	#endif
+		// the sweep is not restarted; collection picks up at the current
+		// point and ends once every point has been collected once.
+		int points = current_props._sweep_points;
+		for(auto& w: collectMeasurementPending)
+			w = 0;
+		for(int i = 0; i < points; i++)
+			collectMeasurementPending[i / 32] |= 1u << (i % 32);
+		collectMeasurementRemaining = points;
+		registers[0x46] = uint8_t(points);
+		registers[0x47] = uint8_t(points >> 8);
+		collectMeasurementSkip = true;
+		calCollectProgress = 0;
+		__sync_synchronize();
 		collectMeasurementType = type;
 	}
+	void cal_collect_abort(void) {
+		if(collectMeasurementType < 0)
+			return;
+		collectMeasurementType = -1;
+		calCollectProgress = -1;
+		registers[0x46] = 0;
+		registers[0x47] = 0;
+	#if BOARD_REVISION >= 4
+		sys_setTimings_args args {0, 1};
+		sys_syscall(5, &args);
+	#else
+		vnaMeasurement.ecalIntervalPoints = MEASUREMENT_ECAL_INTERVAL;
+		vnaMeasurement.nPeriodsMultiplier = current_props._avg;
+	#endif
+		ui_cal_collected();
+	}
 	void cal_done(void) {
 		current_props._cal_status |= CALSTAT_APPLY;
 		vnaMeasurement.measurement_mode = (enum MeasurementMode) current_props._measurement_mode;
@@ -2075,6 +2683,8 @@ namespace UIActions {
 				force = true;
 		}
 		if (force) {
+			// a newly enabled trace may use a channel that was not transformed
+			transform_domain();
 			plot_into_index(measured);
 			force_set_markmap();
 		}
@@ -2083,6 +2693,9 @@ namespace UIActions {
 	{
 		if (trace[t].channel != channel) {
 			trace[t].channel = channel;
+			// the new channel may not have been transformed yet
+			transform_domain();
+			plot_into_index(measured);
 			force_set_markmap();
 		}
 	}
@@ -2136,6 +2749,7 @@ namespace UIActions {
 	int caldata_save(int id) {
 		ecalIgnoreValues = 1000000;
 		int ret = flash_caldata_save(id);
+		calCacheInvalidate(id);
 		ecalIgnoreValues = 20;
 		return ret;
 	}
@@ -8,6 +8,7 @@
 #include <board.hpp>
 #include <mculib/printf.hpp>
 #include "ui.hpp"
+#include "fast_math.hpp"
 
 #define TRUE true
 #define FALSE false
@@ -16,6 +17,7 @@
 
 
 static void cell_draw_marker_info(int x0, int y0);
+static void marker_info_invalidate(void);
 void frequency_string(char *buf, size_t len, freqHz_t freq);
 void frequency_string_short(char *buf, size_t len, freqHz_t freq, char prefix);
 void markmap_all_markers(void);
@@ -38,6 +40,7 @@ uint16_t sweep_count = 0;
 
 small_function<freqHz_t(int)> plot_getFrequencyAt;
 small_function<void()> plot_tick;
+uint16_t plot_cells_drawn = 0;
 
 // alias for plot_getFrequencyAt
 static inline freqHz_t freqAt(int i) {
@@ -58,9 +61,16 @@ static inline freqHz_t freqAt(int i) {
 #error "Too small spi_buffer size SPI_BUFFER_SIZE < CELLWIDTH*CELLHEIGH"
 #endif
 
-#define INDEX(x, y) ((((uint32_t)x)<<16)|(((uint32_t)y)))
-#define CELL_X(i)  (int)(((i)>>16))
-#define CELL_Y(i)  (int)(((i)&0xFFFF))
+// trace_index entries hold x and y in fixed point with INDEX_FRAC
+// fractional bits, for anti-aliased trace lines; CELL_X/CELL_Y round them
+// to pixels.
+#define INDEX_FRAC 4
+#define INDEX_F(xf, yf) ((((uint32_t)(xf))<<16)|(((uint32_t)(yf))&0xFFFF))
+#define INDEX(x, y) INDEX_F((x)<<INDEX_FRAC, (y)<<INDEX_FRAC)
+#define CELL_XF(i) (int)(((i)>>16))
+#define CELL_YF(i) (int)(((i)&0xFFFF))
+#define CELL_X(i)  ((CELL_XF(i) + (1<<(INDEX_FRAC-1))) >> INDEX_FRAC)
+#define CELL_Y(i)  ((CELL_YF(i) + (1<<(INDEX_FRAC-1))) >> INDEX_FRAC)
 
 // indicate dirty cells (not redraw if cell data not changed)
 #define MAX_MARKMAP_X    ((LCD_WIDTH+CELLWIDTH-1)/CELLWIDTH)
@@ -75,6 +85,10 @@ typedef uint32_t map_t;
 #endif
 
 map_t   markmap[2][MAX_MARKMAP_Y];
+// dirty rows of each marked cell, first and last row within the cell
+// (top > bottom if the cell is clean); draw_cell() redraws only these rows.
+uint8_t marktop[2][MAX_MARKMAP_Y][MAX_MARKMAP_X];
+uint8_t markbottom[2][MAX_MARKMAP_Y][MAX_MARKMAP_X];
 uint16_t current_mappage = 0;
 
 uint32_t trace_index[TRACES_MAX][SWEEP_POINTS_MAX];
@@ -133,7 +147,7 @@ void update_grid(void)
 	redraw_request |= REDRAW_FREQUENCY;
 }
 
-static inline int
+static constexpr int
 circle_inout(int x, int y, int r)
 {
 	int d = x*x + y*y - r*r;
@@ -144,43 +158,40 @@ circle_inout(int x, int y, int r)
 	return 0;
 }
 
-static int
+static constexpr int
 polar_grid(int x, int y)
 {
-	int c = config.grid_color;
-	int d;
-
 	// offset to center
 	x -= P_CENTER_X;
 	y -= P_CENTER_Y;
 
 	// outer circle
-	d = circle_inout(x, y, P_RADIUS);
+	int d = circle_inout(x, y, P_RADIUS);
 	if (d < 0) return 0;
-	if (d == 0) return c;
+	if (d == 0) return 1;
 
 	// vertical and horizontal axis
 	if (x == 0 || y == 0)
-		return c;
+		return 1;
 
 	d = circle_inout(x, y, P_RADIUS / 5);
-	if (d == 0) return c;
+	if (d == 0) return 1;
 	if (d > 0) return 0;
 
 	d = circle_inout(x, y, P_RADIUS * 2 / 5);
-	if (d == 0) return c;
+	if (d == 0) return 1;
 	if (d > 0) return 0;
 
 	// cross sloping lines
 	if (x == y || x == -y)
-		return c;
+		return 1;
 
 	d = circle_inout(x, y, P_RADIUS * 3 / 5);
-	if (d == 0) return c;
+	if (d == 0) return 1;
 	if (d > 0) return 0;
 
 	d = circle_inout(x, y, P_RADIUS * 4 / 5);
-	if (d == 0) return c;
+	if (d == 0) return 1;
 	return 0;
 }
 
@@ -188,17 +199,15 @@ polar_grid(int x, int y)
  * Constant Resistance circle: (u - r/(r+1))^2 + v^2 = 1/(r+1)^2
  * Constant Reactance circle:  (u - 1)^2 + (v-1/x)^2 = 1/x^2
  */
-static int
+static constexpr int
 smith_grid(int x, int y)
 {
-	int d;
-
 	// offset to center
 	x -= P_CENTER_X;
 	y -= P_CENTER_Y;
 
 	// outer circle
-	d = circle_inout(x, y, P_RADIUS);
+	int d = circle_inout(x, y, P_RADIUS);
 	if (d < 0) return 0;
 	if (d == 0) return 1;
 
@@ -235,6 +244,46 @@ smith_grid(int x, int y)
 	return 0;
 }
 
+// the smith and polar grids do not depend on the trace scale, so they are
+// rendered at compile time into 1-bit masks in flash instead of being
+// evaluated per pixel. both are symmetric about the horizontal axis; row n
+// of a mask is the grid line n pixels above (or below) P_CENTER_Y.
+#define GRID_MASK_WIDTH (2*P_RADIUS + 1)
+#define GRID_MASK_WORDS ((GRID_MASK_WIDTH + 31) / 32)
+struct grid_mask_t {
+	uint32_t row[P_RADIUS + 1][GRID_MASK_WORDS];
+	constexpr grid_mask_t(int (*grid)(int x, int y)): row() {
+		for (int y = 0; y <= P_RADIUS; y++)
+			for (int x = 0; x < GRID_MASK_WIDTH; x++)
+				if (grid(P_CENTER_X - P_RADIUS + x, P_CENTER_Y - y))
+					row[y][x / 32] |= 1U << (x % 32);
+	}
+};
+static constexpr grid_mask_t smith_grid_mask(smith_grid);
+static constexpr grid_mask_t polar_grid_mask(polar_grid);
+
+// draw the part of a grid mask that falls in the cell at x0, y0
+static void
+draw_grid_mask(const grid_mask_t& mask, int x0, int y0, int w, int h, uint16_t c)
+{
+	int xs = P_CENTER_X - P_RADIUS;
+	int x1 = x0 > xs ? x0 : xs;
+	int x2 = x0 + w < xs + GRID_MASK_WIDTH ? x0 + w : xs + GRID_MASK_WIDTH;
+	for (int y = 0; y < h; y++) {
+		int dy = y + y0 - P_CENTER_Y;
+		if (dy < 0) dy = -dy;
+		if (dy > P_RADIUS)
+			continue;
+		const uint32_t *row = mask.row[dy];
+		uint16_t *buf = &ili9341_spi_buffer[y * CELLWIDTH - x0];
+		for (int x = x1; x < x2; x++) {
+			int i = x - xs;
+			if (row[i / 32] & (1U << (i % 32)))
+				buf[x] = c;
+		}
+	}
+}
+
 int
 smith_grid2(int x, int y, float scale)
 {
@@ -454,6 +503,37 @@ float swr(complexf v) {
 	return (1 + x)/(1 - x);
 }
 
+// the same with the fast_math.hpp approximations, for the plotted values
+// only: their error is far below a pixel but visible in numeric readouts,
+// e.g. swr near total reflection.
+static float fast_logmag(complexf v) {
+	float re = v.real(), im = v.imag();
+	return fast_log10f(re*re + im*im) * 10;
+}
+
+static float fast_phase(complexf v) {
+	float re = v.real(), im = v.imag();
+	return 2 * fast_atan2f(im, re) / M_PI * 90;
+}
+
+static float fast_groupdelay(complexf v, complexf w, float deltaf) {
+	complexf q = w / v;
+	return fast_atan2f(q.imag(), q.real()) / (2 * M_PI * deltaf);
+}
+
+static float fast_linear(complexf v) {
+	float re = v.real(), im = v.imag();
+	return - fast_sqrtf(re*re + im*im);
+}
+
+static float fast_swr(complexf v) {
+	float re = v.real(), im = v.imag();
+	float x = fast_sqrtf(re*re + im*im);
+	if (x > 1)
+		return INFINITY;
+	return (1 + x)/(1 - x);
+}
+
 float resistance(complexf v) {
 	float re = v.real(), im = v.imag();
 	float z0 = 50;
@@ -479,86 +559,241 @@ qualityfactor(complexf v)
   return fabs(i / r);
 }
 
-void
-cartesian_scale(float re, float im, int *xp, int *yp, float scale)
-{
-	//float scale = 4e-3;
-	int x = float2int(re * P_RADIUS * scale);
-	int y = float2int(im * P_RADIUS * scale);
-	if (x < -P_RADIUS) x = -P_RADIUS;
-	if (y < -P_RADIUS) y = -P_RADIUS;
-	if (x > P_RADIUS) x = P_RADIUS;
-	if (y > P_RADIUS) y = P_RADIUS;
-	*xp = WIDTH/2 + x;
-	*yp = HEIGHT/2 - y;
-}
-
-float
-groupdelay_from_array(int i, complexf array[SWEEP_POINTS_MAX])
+template<class T> static float
+groupdelay_of(int i, const T& array, float (*gd)(complexf, complexf, float) = groupdelay)
 {
 	if (i == 0) {
 		float deltaf = freqAt(1) - freqAt(0);
-		return groupdelay(array[0], array[1], deltaf);
-	} else if (i == (SWEEP_POINTS_MAX - 1)) {
+		return gd(array[0], array[1], deltaf);
+	} else if (i == (sweep_points - 1)) {
 		float deltaf = freqAt(i) - freqAt(i-1);
-		return groupdelay(array[i-1], array[i], deltaf);
+		return gd(array[i-1], array[i], deltaf);
 	} else {
 		float deltaf = freqAt(i+1) - freqAt(i-1);
-		return groupdelay(array[i-1], array[i+1], deltaf);
+		return gd(array[i-1], array[i+1], deltaf);
+	}
+}
+
+float
+groupdelay_from_array(int i, complexf array[SWEEP_POINTS_MAX])
+{
+	return groupdelay_of(i, array);
+}
+
+// trace memory: snapshots of a channel taken on request, combined with the
+// live data of a trace while plotting instead of in a separate pass.
+// the arena holds a snapshot of each channel while both fit, and a single
+// snapshot for sweeps of more than SWEEP_POINTS_MAX/2 points.
+// a snapshot is only used while the sweep and the transform settings
+// (domain, window, zoom and gate) are those it was taken with.
+uint8_t trace_math[TRACES_MAX];
+static complexf trace_memory_arena[SWEEP_POINTS_MAX];
+static struct {
+	freqHz_t start, stop;
+	td_key_t td;
+	int8_t slot_ch[2]; // channel held by each slot, -1 if empty
+} trace_memory = { 0, 0, {}, { -1, -1 } };
+
+static int
+trace_memory_slots(void)
+{
+	return 2 * sweep_points <= SWEEP_POINTS_MAX ? 2 : 1;
+}
+
+static bool
+trace_memory_current(void)
+{
+	return trace_memory.start == frequency0
+		&& trace_memory.stop == frequency1
+		&& trace_memory.td == td_key_current();
+}
+
+void
+trace_memory_store(int ch)
+{
+	if (!trace_memory_current()) {
+		trace_memory.start = frequency0;
+		trace_memory.stop = frequency1;
+		trace_memory.td = td_key_current();
+		trace_memory.slot_ch[0] = trace_memory.slot_ch[1] = -1;
 	}
+	int slot = trace_memory_slots() == 2 ? ch : 0;
+	memcpy(&trace_memory_arena[slot * sweep_points], measured[ch], sizeof(complexf) * sweep_points);
+	trace_memory.slot_ch[slot] = ch;
 }
 
-uint32_t
-trace_into_index(int x, int t, int i, complexf array[SWEEP_POINTS_MAX])
+// the snapshot of a channel, or NULL if there is none for the current sweep
+static const complexf*
+trace_memory_get(int ch)
 {
-	int y = 0;
-	float v = 0;
+	if (!trace_memory_current())
+		return NULL;
+	int slot = trace_memory_slots() == 2 ? ch : 0;
+	if (trace_memory.slot_ch[slot] != ch)
+		return NULL;
+	return &trace_memory_arena[slot * sweep_points];
+}
+
+// the points a trace shows: the data of its channel, or the data combined
+// with the channel's memory point by point as they are read.
+struct trace_src_t {
+	const complexf* data;
+	const complexf* mem; // NULL unless math is applied
+	uint8_t math;
+	complexf operator[](int i) const {
+		if (mem == NULL)
+			return data[i];
+		switch (math) {
+		case TRACE_MATH_MEMORY: return mem[i];
+		case TRACE_MATH_SUB:    return data[i] - mem[i];
+		default:                return divide(data[i], mem[i]);
+		}
+	}
+	// data / memory; a zero memory point gives INFINITY as swr() does
+	// rather than the NaN of the complex division.
+	static complexf divide(complexf d, complexf m) {
+		if (m.real() == 0 && m.imag() == 0)
+			return complexf(INFINITY, 0);
+		return d / m;
+	}
+	bool operator==(const trace_src_t& other) const {
+		return data == other.data && mem == other.mem && math == other.math;
+	}
+};
+
+static trace_src_t
+trace_src(int t, const complexf array[SWEEP_POINTS_MAX])
+{
+	trace_src_t src = { array, NULL, TRACE_MATH_OFF };
+	if (trace_math[t] != TRACE_MATH_OFF) {
+		src.mem = trace_memory_get(trace[t].channel);
+		if (src.mem != NULL)
+			src.math = trace_math[t];
+	}
+	return src;
+}
+
+static float real_part(complexf v) { return v.real(); }
+static float imag_part(complexf v) { return v.imag(); }
+
+// value of a point in the given trace format, for formats that are
+// computed from that point alone; NULL for delay, smith and polar.
+// fast selects the approximations used for plotting.
+typedef float (*trace_value_fn_t)(complexf v);
+static trace_value_fn_t
+trace_value_fn(int type, bool fast)
+{
+	switch (type) {
+	case TRC_LOGMAG: return fast ? fast_logmag : logmag;
+	case TRC_PHASE:  return fast ? fast_phase : phase;
+	case TRC_LINEAR: return fast ? fast_linear : linear;
+	case TRC_SWR:    return fast ? fast_swr : swr;
+	case TRC_REAL:   return real_part;
+	case TRC_IMAG:   return imag_part;
+	case TRC_R:      return resistance;
+	case TRC_X:      return reactance;
+	case TRC_Q:      return qualityfactor;
+	}
+	return NULL;
+}
+
+static float
+trace_value_of(int type, const trace_src_t& array, int i)
+{
+	if (type == TRC_DELAY)
+		return groupdelay_of(i, array);
+	trace_value_fn_t fn = trace_value_fn(type, false);
+	return fn ? fn(array[i]) : 0;
+}
+
+// values of each enabled trace in its format for plotting, computed with
+// the fast approximations once per point and update, and the source they
+// were computed from. numeric readouts (marker values, L/C matching) do
+// not use them; they compute exact values with trace_value_of() instead.
+static float trace_value[TRACES_MAX][SWEEP_POINTS_MAX];
+static trace_src_t trace_value_src[TRACES_MAX];
+
+// compute the values of points from to to (inclusive) of trace t
+static void
+trace_compute_values(int t, const trace_src_t& array, int from, int to)
+{
+	float *out = trace_value[t];
+	int type = trace[t].type;
+	trace_value_src[t] = array;
+	if (type == TRC_DELAY) {
+		for (int i = from; i <= to; i++)
+			out[i] = groupdelay_of(i, array, fast_groupdelay);
+		return;
+	}
+	trace_value_fn_t fn = trace_value_fn(type, true);
+	if (fn == NULL)
+		return;
+	for (int i = from; i <= to; i++)
+		out[i] = fn(array[i]);
+}
+
+// exact value of a point of a channel in the given format
+static float
+channel_value_at(int ch, int type, int i)
+{
+	trace_src_t plain = { measured[ch], NULL, TRACE_MATH_OFF };
+	return trace_value_of(type, plain, i);
+}
+
+// mapping from the values of a trace to positions on the screen, in
+// INDEX_FRAC fixed point, computed from the trace settings once per update.
+// rectangular formats: y = offset + value * scale, clamped to [lo, hi].
+// smith/polar: x and y of the coefficient times scale, clamped to the
+// chart radius [lo, hi] around the center.
+typedef struct {
+	float scale;
+	float offset;
+	float lo, hi;
+	bool chart;
+} trace_projection_t;
+
+static void
+trace_projection(int t, trace_projection_t *p)
+{
+	const float grid = GRIDY << INDEX_FRAC;
 	float refpos = 8 - get_trace_refpos(t);
 	float scale = 1 / get_trace_scale(t);
-	complexf coeff = array[i];
+	p->chart = false;
+	p->lo = 0;
+	p->hi = 8 * grid;
 	switch (trace[t].type) {
-	case TRC_LOGMAG:
-		v = refpos - logmag(coeff) * scale;
-		break;
-	case TRC_PHASE:
-		v = refpos - phase(coeff) * scale;
-		break;
-	case TRC_DELAY:
-		v = refpos - groupdelay_from_array(i, array) * scale;
+	case TRC_SMITH:
+	//case TRC_ADMIT:
+	case TRC_POLAR:
+		p->chart = true;
+		p->scale = (P_RADIUS << INDEX_FRAC) * scale;
+		p->offset = 0;
+		p->hi = P_RADIUS << INDEX_FRAC;
+		p->lo = -p->hi;
 		break;
 	case TRC_LINEAR:
-		v = refpos + linear(coeff) * scale;
+		p->scale = scale * grid;
+		p->offset = refpos * grid;
 		break;
 	case TRC_SWR:
-		v = refpos+ (1 - swr(coeff)) * scale;
-		break;
-	case TRC_REAL:
-		v = refpos - coeff.real() * scale;
-		break;
-	case TRC_IMAG:
-		v = refpos - coeff.imag() * scale;
+		p->scale = -scale * grid;
+		p->offset = (refpos + scale) * grid;
 		break;
-	case TRC_R:
-		v = refpos - resistance(coeff) * scale;
-		break;
-	case TRC_X:
-		v = refpos - reactance(coeff) * scale;
-		break;
-	case TRC_Q:
-		v = refpos - qualityfactor(coeff) * scale;
-		break;
-
-	case TRC_SMITH:
-	//case TRC_ADMIT:
-	case TRC_POLAR:
-		cartesian_scale(coeff.real(), coeff.imag(), &x, &y, scale);
-		return INDEX(x +CELLOFFSETX, y);
+	default:
+		p->scale = -scale * grid;
+		p->offset = refpos * grid;
 		break;
 	}
-	if (v < 0) v = 0;
-	if (v > 8) v = 8;
-	y = float2int(v * GRIDY);
-	return INDEX(x +CELLOFFSETX, y);
+}
+
+static inline int
+trace_project(const trace_projection_t *p, float v)
+{
+	v *= p->scale;
+	v += p->offset;
+	if (v < p->lo) v = p->lo;
+	if (v > p->hi) v = p->hi;
+	return float2int(v);
 }
 
 static int
@@ -692,32 +927,33 @@ gamma2reactance(char *buf, int len, complexf coeff)
 }
 
 static void
-trace_get_value_string(int t, char *buf, int len, complexf array[SWEEP_POINTS_MAX], int i)
+trace_get_value_string(int t, char *buf, int len, const trace_src_t& array, int i)
 {
 	float v;
 	complexf coeff = array[i];
-	switch (trace[t].type) {
+	int type = trace[t].type;
+	switch (type) {
 	case TRC_LOGMAG:
-		v = logmag(coeff);
+		v = trace_value_of(type, array, i);
 		if (v == -INFINITY)
 			chsnprintf(buf, len, "-INF dB");
 		else
 			chsnprintf(buf, len, "%.2fdB", v);
 		break;
 	case TRC_PHASE:
-		v = phase(coeff);
+		v = trace_value_of(type, array, i);
 		chsnprintf(buf, len, "%.2f" S_DEGREE, v);
 		break;
 	case TRC_DELAY:
-		v = groupdelay_from_array(i, array);
+		v = trace_value_of(type, array, i);
 		string_value_with_prefix(buf, len, v, 's');
 		break;
 	case TRC_LINEAR:
-		v = linear(coeff);
+		v = trace_value_of(type, array, i);
 		chsnprintf(buf, len, "%.2f", v);
 		break;
 	case TRC_SWR:
-		v = swr(coeff);
+		v = trace_value_of(type, array, i);
 		chsnprintf(buf, len, "%.2f", v);
 		break;
 	case TRC_SMITH:
@@ -736,7 +972,7 @@ trace_get_value_string(int t, char *buf, int len, complexf array[SWEEP_POINTS_MA
 		gamma2reactance(buf, len, coeff);
 		break;
 	case TRC_Q:
-		chsnprintf(buf, len, "%.2f", qualityfactor(coeff));
+		chsnprintf(buf, len, "%.2f", trace_value_of(type, array, i));
 		break;
 	//case TRC_ADMIT:
 	case TRC_POLAR:
@@ -747,33 +983,34 @@ trace_get_value_string(int t, char *buf, int len, complexf array[SWEEP_POINTS_MA
 
 
 static void
-trace_get_value_string_delta(int t, char *buf, int len, complexf array[SWEEP_POINTS_MAX], int index, int index_ref)
+trace_get_value_string_delta(int t, char *buf, int len, const trace_src_t& array, int index, int index_ref)
 {
 	complexf coeff = array[index];
 	complexf coeff_ref = array[index_ref];
 	float v;
-	switch (trace[t].type) {
+	int type = trace[t].type;
+	switch (type) {
 	case TRC_LOGMAG:
-		v = logmag(coeff) - logmag(coeff_ref);
+		v = trace_value_of(type, array, index) - trace_value_of(type, array, index_ref);
 		if (v == -INFINITY)
 			chsnprintf(buf, len, S_DELTA "-INF dB");
 		else
 			chsnprintf(buf, len, S_DELTA "%.2fdB", v);
 		break;
 	case TRC_PHASE:
-		v = phase(coeff) - phase(coeff_ref);
+		v = trace_value_of(type, array, index) - trace_value_of(type, array, index_ref);
 		chsnprintf(buf, len, S_DELTA "%.2f" S_DEGREE, v);
 		break;
 	case TRC_DELAY:
-		v = groupdelay_from_array(index, array) - groupdelay_from_array(index_ref, array);
+		v = trace_value_of(type, array, index) - trace_value_of(type, array, index_ref);
 		string_value_with_prefix(buf, len, v, 's');
 		break;
 	case TRC_LINEAR:
-		v = linear(coeff) - linear(coeff_ref);
+		v = trace_value_of(type, array, index) - trace_value_of(type, array, index_ref);
 		chsnprintf(buf, len, S_DELTA "%.2f", v);
 		break;
 	case TRC_SWR:
-		v = swr(coeff) - swr(coeff_ref);
+		v = trace_value_of(type, array, index) - trace_value_of(type, array, index_ref);
 		chsnprintf(buf, len, S_DELTA "%.2f", v);
 		break;
 	case TRC_SMITH:
@@ -792,7 +1029,7 @@ trace_get_value_string_delta(int t, char *buf, int len, complexf array[SWEEP_POI
 		gamma2reactance(buf, len, coeff);
 		break;
 	case TRC_Q:
-		chsnprintf(buf, len, S_DELTA "%.2f", qualityfactor(coeff) - qualityfactor(coeff_ref));
+		chsnprintf(buf, len, S_DELTA "%.2f", trace_value_of(type, array, index) - trace_value_of(type, array, index_ref));
 		break;
 	//case TRC_ADMIT:
 	case TRC_POLAR:
@@ -827,21 +1064,34 @@ trace_get_info(int t, char *buf, int len)
 }
 
 static float time_of_index(int idx) {
+	 if (td_zoom_active())
+		 return td_zoom_start + (td_zoom_stop - td_zoom_start) * idx / (sweep_points - 1);
 	 return 1.0 / (float)(plot_getFrequencyAt(1) - plot_getFrequencyAt(0)) / (float)FFT_SIZE * idx;
 }
 
 static float distance_of_index(int idx) {
 #define SPEED_OF_LIGHT 299792458
-	 float distance = ((float)idx * (float)SPEED_OF_LIGHT) / ( (float)(plot_getFrequencyAt(1) - plot_getFrequencyAt(0)) * (float)FFT_SIZE * 2.0);
+	 float distance = time_of_index(idx) * (float)SPEED_OF_LIGHT / 2.0;
 	 return distance * velocity_factor;
 }
 
 
 static inline void
-mark_map(int x, int y)
+mark_map_rows(int x, int y, int top, int bottom)
 {
-	if (y >= 0 && y < MAX_MARKMAP_Y && x >= 0 && x < MAX_MARKMAP_X)
+	if (y >= 0 && y < MAX_MARKMAP_Y && x >= 0 && x < MAX_MARKMAP_X) {
 		markmap[current_mappage][y] |= 1 << x;
+		uint8_t *t = &marktop[current_mappage][y][x];
+		uint8_t *b = &markbottom[current_mappage][y][x];
+		if (top < *t) *t = top;
+		if (bottom > *b) *b = bottom;
+	}
+}
+
+static inline void
+mark_map(int x, int y)
+{
+	mark_map_rows(x, y, 0, CELLHEIGHT - 1);
 }
 
 static inline void
@@ -854,12 +1104,16 @@ static inline void
 clear_markmap(void)
 {
 	memset(markmap[current_mappage], 0, sizeof markmap[current_mappage]);
+	memset(marktop[current_mappage], 0xff, sizeof marktop[current_mappage]);
+	memset(markbottom[current_mappage], 0, sizeof markbottom[current_mappage]);
 }
 
 void
 force_set_markmap(void)
 {
 	memset(markmap[current_mappage], 0xff, sizeof markmap[current_mappage]);
+	memset(marktop[current_mappage], 0, sizeof marktop[current_mappage]);
+	memset(markbottom[current_mappage], CELLHEIGHT - 1, sizeof markbottom[current_mappage]);
 }
 
 void
@@ -882,91 +1136,289 @@ markmap_upperarea(void)
 	invalidate_rect(0, 0, AREA_WIDTH_NORMAL, 3*FONT_STR_HEIGHT);
 }
 
+// mark the rows of each cell that cell_drawline() touches when drawing
+// the segment from (xa, ya) to (xb, yb), in INDEX_FRAC fixed point.
+// cell_drawline() may blend pixels one to the side of the segment, so each
+// cell column takes the part of the segment from a pixel before it to a
+// pixel after it, and two more rows each way.
 static void
-mark_cells_from_index(void)
+mark_segment(int xa, int ya, int xb, int yb)
 {
-	int t, i, j;
+	const int one = 1 << INDEX_FRAC;
+	if (xa > xb) { SWAP(xa, xb); SWAP(ya, yb); }
+	int m0 = xa > one ? ((xa - one) >> INDEX_FRAC) / CELLWIDTH : 0;
+	int m1 = ((xb + one) >> INDEX_FRAC) / CELLWIDTH;
+	for (int m = m0; m <= m1; m++) {
+		int cx0 = (m * CELLWIDTH - 1) * one;
+		int cx1 = (m * CELLWIDTH + CELLWIDTH) * one;
+		if (cx0 < xa) cx0 = xa;
+		if (cx1 > xb) cx1 = xb;
+		int y0 = ya, y1 = yb;
+		if (xb != xa) {
+			y0 = ya + (yb - ya) * (cx0 - xa) / (xb - xa);
+			y1 = ya + (yb - ya) * (cx1 - xa) / (xb - xa);
+		}
+		if (y0 > y1) SWAP(y0, y1);
+		y0 = (y0 >> INDEX_FRAC) - 2;
+		y1 = (y1 >> INDEX_FRAC) + 2;
+		if (y0 < 0) y0 = 0;
+		for (int n = y0 / CELLHEIGHT; n <= y1 / CELLHEIGHT; n++) {
+			int top = y0 - n * CELLHEIGHT;
+			int bottom = y1 - n * CELLHEIGHT;
+			if (top < 0) top = 0;
+			if (bottom > CELLHEIGHT - 1) bottom = CELLHEIGHT - 1;
+			mark_map_rows(m, n, top, bottom);
+		}
+	}
+}
+
+#if SWEEP_POINTS_MAX > WIDTH + 1
+// with more points than screen columns, rectangular traces are drawn
+// through the min and max of their points in each column instead of
+// through every point, so drawing costs are bounded by WIDTH and peaks
+// stay visible.
+#define TRACE_DECIMATE
+static uint32_t trace_envelope[TRACES_MAX][2 * (WIDTH + 1)];
+static uint16_t trace_envelope_count[TRACES_MAX]; // 0 if not decimated
+
+// build the envelope of index into out, returns its number of points
+static int
+trace_decimate(const uint32_t *index, uint32_t *out)
+{
+	int n = 0;
+	int i = 0;
+	while (i < sweep_points) {
+		int x = CELL_X(index[i]);
+		int lo = i, hi = i;
+		for (i++; i < sweep_points && CELL_X(index[i]) == x; i++) {
+			if (CELL_YF(index[i]) < CELL_YF(index[lo])) lo = i;
+			if (CELL_YF(index[i]) > CELL_YF(index[hi])) hi = i;
+		}
+		// keep the order in which the trace passes them
+		int first = lo < hi ? lo : hi;
+		int second = lo < hi ? hi : lo;
+		out[n++] = INDEX_F(x << INDEX_FRAC, CELL_YF(index[first]));
+		if (second != first)
+			out[n++] = INDEX_F(x << INDEX_FRAC, CELL_YF(index[second]));
+	}
+	return n;
+}
+#endif
+
+// the points a trace is drawn through, returns their number
+static int
+trace_plot_points(int t, const uint32_t **index)
+{
+#ifdef TRACE_DECIMATE
+	if (trace_envelope_count[t]) {
+		*index = trace_envelope[t];
+		return trace_envelope_count[t];
+	}
+#endif
+	*index = trace_index[t];
+	return sweep_points;
+}
+
+// mark cells of the segments that join points from to to (inclusive)
+// to their neighbours; decimated traces are marked whole.
+static void
+mark_cells_from_index(int from, int to)
+{
+	int t, i;
 	/* mark cells between each neighber points */
-	map_t *map = &markmap[current_mappage][0];
 	for (t = 0; t < TRACES_MAX; t++) {
 		if (!trace[t].enabled)
 			continue;
-		uint32_t *index = &trace_index[t][0];
-		int m0 = CELL_X(index[0]) / CELLWIDTH;
-		int n0 = CELL_Y(index[0]) / CELLHEIGHT;
-		map[n0] |= 1 << m0;
-		for (i = 1; i < sweep_points; i++) {
-		int m1 = CELL_X(index[i]) / CELLWIDTH;
-		int n1 = CELL_Y(index[i]) / CELLHEIGHT;
-		if (m0 == m1 && n0 == n1)
-			continue;
-		int x0 = m0; int x1 = m1; if (x0>x1) SWAP(x0, x1); m0 = m1;
-		int y0 = n0; int y1 = n1; if (y0>y1) SWAP(y0, y1); n0 = n1;
-		for (; y0 <= y1; y0++)
-			for (j = x0; j <= x1; j++) {
-				if(y0 >= 0 && y0 < MAX_MARKMAP_Y)
-					map[y0] |= 1 << j;
-			}
+		const uint32_t *index;
+		int count = trace_plot_points(t, &index);
+		int i0 = from > 1 ? from : 1;
+		int i1 = to + 1 < count - 1 ? to + 1 : count - 1;
+		if (index != trace_index[t]) {
+			i0 = 1;
+			i1 = count - 1;
 		}
+		for (i = i0; i <= i1; i++)
+			mark_segment(CELL_XF(index[i-1]), CELL_YF(index[i-1]), CELL_XF(index[i]), CELL_YF(index[i]));
 	}
 }
 
-void plot_into_index(complexf measured[2][SWEEP_POINTS_MAX])
+// points of measured[] changed since the last plot, and the trace settings
+// and number of points trace_index was computed with
+static int plot_changed_from = 0, plot_changed_to = -1;
+static trace_t plot_trace[TRACES_MAX];
+static int plot_points;
+
+void
+plot_points_changed(int from, int to)
+{
+	if (plot_changed_to < plot_changed_from) {
+		plot_changed_from = from;
+		plot_changed_to = to;
+		return;
+	}
+	if (from < plot_changed_from) plot_changed_from = from;
+	if (to > plot_changed_to) plot_changed_to = to;
+}
+
+// recompute trace values and indexes of points from to to (inclusive)
+static void
+plot_index_range(complexf measured[2][SWEEP_POINTS_MAX], int from, int to)
 {
-	mark_cells_from_index();
 	int i, t;
-	for (i = 0; i < sweep_points; i++) {
-		int x = i * WIDTH / (sweep_points-1);
+	mark_cells_from_index(from, to);
+	for (t = 0; t < TRACES_MAX; t++) {
+		if (trace[t].enabled)
+			trace_compute_values(t, trace_src(t, measured[trace[t].channel]), from, to);
+	}
+	trace_projection_t proj[TRACES_MAX];
+	for (t = 0; t < TRACES_MAX; t++) {
+		if (trace[t].enabled)
+			trace_projection(t, &proj[t]);
+	}
+	for (i = from; i <= to; i++) {
+		int x = ((i * WIDTH << INDEX_FRAC) / (sweep_points-1)) + (CELLOFFSETX << INDEX_FRAC);
 		for (t = 0; t < TRACES_MAX; t++) {
 			if (!trace[t].enabled)
 				continue;
-			int n = trace[t].channel;
-			trace_index[t][i] = trace_into_index(x, t, i, measured[n]);
+			const trace_projection_t *p = &proj[t];
+			if (p->chart) {
+				complexf coeff = trace_value_src[t][i];
+				trace_index[t][i] = INDEX_F(
+					((WIDTH/2 + CELLOFFSETX) << INDEX_FRAC) + trace_project(p, coeff.real()),
+					((HEIGHT/2) << INDEX_FRAC) - trace_project(p, coeff.imag()));
+			} else
+				trace_index[t][i] = INDEX_F(x, trace_project(p, trace_value[t][i]));
 		}
 	}
-	// Current scan count
-	sweep_count++;
-	mark_cells_from_index();
+#ifdef TRACE_DECIMATE
+	for (t = 0; t < TRACES_MAX; t++) {
+		uint32_t trace_type = (1 << trace[t].type);
+		trace_envelope_count[t] = 0;
+		if (trace[t].enabled && sweep_points > WIDTH + 1
+			&& !(trace_type & ((1 << TRC_SMITH) | (1 << TRC_POLAR))))
+			trace_envelope_count[t] = trace_decimate(trace_index[t], trace_envelope[t]);
+	}
+#endif
+	plot_changed_from = 0;
+	plot_changed_to = -1;
+	mark_cells_from_index(from, to);
 	markmap_all_markers();
 	redraw_request |= REDRAW_CELLS;
 }
 
-//
-// in most cases _compute_outcode clip calculation not give render line speedup
-//
-static inline void
-cell_drawline(int x0, int y0, int x1, int y1, int c)
+void plot_into_index(complexf measured[2][SWEEP_POINTS_MAX])
 {
-	if (x0 < 0 && x1 < 0) return;
-	if (y0 < 0 && y1 < 0) return;
-	if (x0 >= CELLWIDTH && x1 >= CELLWIDTH) return;
-	if (y0 >= CELLHEIGHT && y1 >= CELLHEIGHT) return;
-
-	// modifed Bresenham's line algorithm, see https://en.wikipedia.org/wiki/Bresenham%27s_line_algorithm
-	if (x1 < x0) { SWAP(x0, x1); SWAP(y0, y1); }
-	int dx = x1 - x0;
-	int dy = y1 - y0, sy = 1; if (dy < 0) { dy = -dy; sy = -1; }
-	int err = (dx > dy ? dx : -dy) / 2;
+	memcpy(plot_trace, trace, sizeof plot_trace);
+	plot_points = sweep_points;
+	plot_index_range(measured, 0, sweep_points - 1);
+}
 
-	while (1) {
-		if (y0 >= 0 && y0 < CELLHEIGHT && x0 >= 0 && x0 < CELLWIDTH)
-			ili9341_spi_buffer[y0 * CELLWIDTH + x0] |= c;
-		if (x0 == x1 && y0 == y1)
+void plot_into_index_changed(complexf measured[2][SWEEP_POINTS_MAX])
+{
+	if (plot_changed_to < plot_changed_from)
+		return;
+	// anything but the data changed: recompute all points
+	if (plot_points != sweep_points || memcmp(plot_trace, trace, sizeof plot_trace) != 0) {
+		plot_into_index(measured);
+		return;
+	}
+	for (int t = 0; t < TRACES_MAX; t++) {
+		if (trace[t].enabled && !(trace_value_src[t] == trace_src(t, measured[trace[t].channel]))) {
+			plot_into_index(measured);
 			return;
-		int e2 = err;
-		if (e2 > -dx) { err -= dy; x0++;  }
-		if (e2 <  dy) { err += dx; y0+=sy;}
+		}
+	}
+	// group delay of a point depends on its neighbours
+	int from = plot_changed_from > 0 ? plot_changed_from - 1 : 0;
+	int to = plot_changed_to < sweep_points - 1 ? plot_changed_to + 1 : sweep_points - 1;
+	plot_index_range(measured, from, to);
+}
+
+// blend fg over bg with alpha 0..32; colors are RGB565 in panel byte order
+static inline uint16_t
+blend_rgb565(uint16_t bg, uint16_t fg, uint32_t alpha)
+{
+	uint32_t b = byteReverse16(bg);
+	uint32_t f = byteReverse16(fg);
+	// spread to 0b00000gggggg00000rrrrr000000bbbbb so that each field has
+	// room for the borrow of the difference
+	b = (b | (b << 16)) & 0x07e0f81f;
+	f = (f | (f << 16)) & 0x07e0f81f;
+	b = (b + (((f - b) * alpha) >> 5)) & 0x07e0f81f;
+	return byteReverse16(b | (b >> 16));
+}
+
+static inline void
+cell_blend_pixel(int x, int y, uint16_t c, uint32_t alpha)
+{
+	if (alpha && y >= 0 && y < CELLHEIGHT && x >= 0 && x < CELLWIDTH) {
+		uint16_t *p = &ili9341_spi_buffer[y * CELLWIDTH + x];
+		*p = blend_rgb565(*p, c, alpha);
+	}
+}
+
+//
+// anti-aliased line (Xiaolin Wu) between cell relative points in INDEX_FRAC
+// fixed point. each pixel step along the major axis blends the two pixels
+// straddling the line on the minor axis. the pixel step at the end point is
+// left to the following segment unless last is set, so that the pixels
+// where segments join are not blended twice.
+//
+static void
+cell_drawline(int x0, int y0, int x1, int y1, uint16_t c, bool last)
+{
+	const int one = 1 << INDEX_FRAC;
+	// the pixel steps reach half a pixel past the end points and blend
+	// pixels up to one away from the line, so a segment up to two pixels
+	// outside the cell can still touch its edge
+	if (x0 < -2 * one && x1 < -2 * one) return;
+	if (y0 < -2 * one && y1 < -2 * one) return;
+	if (x0 >= (CELLWIDTH + 1) * one && x1 >= (CELLWIDTH + 1) * one) return;
+	if (y0 >= (CELLHEIGHT + 1) * one && y1 >= (CELLHEIGHT + 1) * one) return;
+
+	int dx = x1 - x0, dy = y1 - y0;
+	bool steep = (dy < 0 ? -dy : dy) > (dx < 0 ? -dx : dx);
+	if (steep) { SWAP(x0, y0); SWAP(x1, y1); SWAP(dx, dy); }
+	int size = steep ? CELLHEIGHT : CELLWIDTH;
+	int dir = dx < 0 ? -1 : 1;
+	// major axis pixels from round(x0) up to, not including, round(x1)
+	int xs = (x0 + one / 2) >> INDEX_FRAC;
+	int xe = (x1 + one / 2) >> INDEX_FRAC;
+	if (last) xe += dir;
+	if (dir > 0) {
+		if (xs < 0) xs = 0;
+		if (xe > size) xe = size;
+		if (xs >= xe) return;
+	} else {
+		if (xs > size - 1) xs = size - 1;
+		if (xe < -1) xe = -1;
+		if (xs <= xe) return;
+	}
+	// minor axis position in 16.16 and its change per pixel step
+	int32_t grad = dx ? (dy << 16) / dx : 0;
+	int32_t y = (y0 << (16 - INDEX_FRAC)) + ((grad * ((xs << INDEX_FRAC) - x0)) >> INDEX_FRAC);
+	grad *= dir;
+	for (int x = xs; x != xe; x += dir, y += grad) {
+		int yi = y >> 16;
+		uint32_t a = (y >> 11) & 31;
+		if (steep) {
+			cell_blend_pixel(yi, x, c, 32 - a);
+			cell_blend_pixel(yi + 1, x, c, a);
+		} else {
+			cell_blend_pixel(x, yi, c, 32 - a);
+			cell_blend_pixel(x, yi + 1, c, a);
+		}
 	}
 }
 
 // Give a little speedup then draw rectangular plot (50 systick on all calls, all render req 700 systick)
 // Write more difficult algoritm for seach indexes not give speedup
 static int
-search_index_range_x(int x1, int x2, uint32_t *index, int *i0, int *i1)
+search_index_range_x(int x1, int x2, const uint32_t *index, int count, int *i0, int *i1)
 {
 	int i, j;
 	int head = 0;
-	int tail = sweep_points;
+	int tail = count;
 	int idx_x;
 
 	// Search index point in cell
@@ -995,9 +1447,9 @@ search_index_range_x(int x1, int x2, uint32_t *index, int *i0, int *i1)
 	*i0 = j;
 	// Search index right from point
 	do {
-		if (i >=sweep_points-1) break;
+		if (i >=count-1) break;
 		i++;
-	} while (i < sweep_points-1 && CELL_X(index[i]) < x2);
+	} while (i < count-1 && CELL_X(index[i]) < x2);
 	*i1 = i;
 
 	return TRUE;
@@ -1006,17 +1458,21 @@ search_index_range_x(int x1, int x2, uint32_t *index, int *i0, int *i1)
 static void
 cell_blit_bitmap(int x, int y, uint16_t w, uint16_t h, const uint8_t *bmp)
 {
-  if (x <= -w)
+  if (x <= -w || x >= CELLWIDTH)
     return;
-  uint8_t bits = 0;
-  int c = h+y, r;
-  for (; y < c; y++) {
-    for (r = 0; r < w; r++) {
-      if ((r&7)==0) bits = *bmp++;
-      if (y >= 0 && x+r >= 0 && y < CELLHEIGHT && x+r < CELLWIDTH && (0x80 & bits))
-        ili9341_spi_buffer[y*CELLWIDTH + x + r] = foreground_color;
-      bits <<= 1;
-    }
+  // clip to the cell once, then only test bits
+  int stride = (w + 7) / 8;
+  int c0 = x < 0 ? -x : 0;
+  int c1 = x + w > CELLWIDTH ? CELLWIDTH - x : w;
+  for (int r = 0; r < h; r++, bmp += stride) {
+    if (y + r < 0)
+      continue;
+    if (y + r >= CELLHEIGHT)
+      break;
+    uint16_t *out = &ili9341_spi_buffer[(y + r) * CELLWIDTH + x];
+    for (int c = c0; c < c1; c++)
+      if (bmp[c >> 3] & (0x80 >> (c & 7)))
+        out[c] = foreground_color;
   }
 }
 
@@ -1231,11 +1687,11 @@ marker_search(MarkerSearchModes mode)
 	if (uistat.current_trace == -1)
 		return -1;
 
-	int value = CELL_Y(trace_index[uistat.current_trace][0]);
+	int value = CELL_YF(trace_index[uistat.current_trace][0]);
 	for (i = 0; i < sweep_points; i++) {
 		uint32_t index = trace_index[uistat.current_trace][i];
-		if ((*compare)(value, CELL_Y(index))) {
-			value = CELL_Y(index);
+		if ((*compare)(value, CELL_YF(index))) {
+			value = CELL_YF(index);
 			found = i;
 		}
 	}
@@ -1253,21 +1709,21 @@ marker_search_dir(MarkerSearchModes mode, int from, int dir)
 	if (uistat.current_trace == -1)
 		return -1;
 
-	int value = CELL_Y(trace_index[uistat.current_trace][from]);
+	int value = CELL_YF(trace_index[uistat.current_trace][from]);
 	for (i = from + dir; i >= 0 && i < sweep_points; i+=dir) {
 		uint32_t index = trace_index[uistat.current_trace][i];
-		if ((*compare)(value, CELL_Y(index)))
+		if ((*compare)(value, CELL_YF(index)))
 			break;
-		value = CELL_Y(index);
+		value = CELL_YF(index);
 	}
 
 	for (;i >= 0 && i < sweep_points; i+=dir) {
 		uint32_t index = trace_index[uistat.current_trace][i];
-		if ((*compare)(CELL_Y(index), value)) {
+		if ((*compare)(CELL_YF(index), value)) {
 			break;
 		}
 		found = i;
-		value = CELL_Y(index);
+		value = CELL_YF(index);
 	}
 	return found;
 }
@@ -1332,13 +1788,14 @@ markmap_all_markers(void)
 
 bool plot_checkerBoard = false;
 bool plot_shadeCells = false;
+// redraw rows top to bottom of a cell
 static void
-draw_cell(int m, int n)
+draw_cell(int m, int n, int top, int bottom)
 {
 	int x0 = m * CELLWIDTH;
-	int y0 = n * CELLHEIGHT;
+	int y0 = n * CELLHEIGHT + top;
 	int w = CELLWIDTH;
-	int h = CELLHEIGHT;
+	int h = bottom - top + 1;
 	int x, y;
 	int i0, i1;
 	int i;
@@ -1410,16 +1867,10 @@ draw_cell(int m, int n)
 			}
 		}
 	}
-	if (grid_mode & GRID_SMITH) {
-		for (y = 0; y < h; y++)
-			for (x = 0; x < w; x++)
-				if (smith_grid(x + x0, y + y0)) ili9341_spi_buffer[y * CELLWIDTH + x] = c;
-	}
-	else if (grid_mode & GRID_POLAR) {
-		for (y = 0; y < h; y++)
-			for (x = 0; x < w; x++)
-				if (polar_grid(x + x0, y + y0)) ili9341_spi_buffer[y * CELLWIDTH + x] = c;
-	}
+	if (grid_mode & GRID_SMITH)
+		draw_grid_mask(smith_grid_mask, x0, y0, w, h, c);
+	else if (grid_mode & GRID_POLAR)
+		draw_grid_mask(polar_grid_mask, x0, y0, w, h, c);
 	else if (grid_mode & GRID_ADMIT) {
 		for (y = 0; y < h; y++)
 			for (x = 0; x < w; x++)
@@ -1434,18 +1885,19 @@ draw_cell(int m, int n)
 		// draw polar plot (check all points)
 		i0 = 0;
 		i1 = 0;
+		const uint32_t *index;
+		int count = trace_plot_points(t, &index);
 		uint32_t trace_type = (1 << trace[t].type);
 		if (trace_type & ((1 << TRC_SMITH) | (1 << TRC_POLAR)))
-			i1 = sweep_points - 1;
+			i1 = count - 1;
 		else
-			search_index_range_x(x0, x0 + w, trace_index[t], &i0, &i1);
-		uint32_t *index = trace_index[t];
+			search_index_range_x(x0, x0 + w, index, count, &i0, &i1);
 		for (i = i0; i < i1; i++) {
-			int x1 = CELL_X(index[i]) - x0;
-			int y1 = CELL_Y(index[i]) - y0;
-			int x2 = CELL_X(index[i + 1]) - x0;
-			int y2 = CELL_Y(index[i + 1]) - y0;
-			cell_drawline(x1, y1, x2, y2, c);
+			int x1 = CELL_XF(index[i]) - (x0 << INDEX_FRAC);
+			int y1 = CELL_YF(index[i]) - (y0 << INDEX_FRAC);
+			int x2 = CELL_XF(index[i + 1]) - (x0 << INDEX_FRAC);
+			int y2 = CELL_YF(index[i + 1]) - (y0 << INDEX_FRAC);
+			cell_drawline(x1, y1, x2, y2, c, i + 1 == count - 1);
 		}
 	}
 
@@ -1511,10 +1963,14 @@ void
 draw_all_cells(bool flush_markmap)
 {
 	int m, n;
+	marker_info_invalidate();
 	for (m = 0; m < (area_width+CELLWIDTH-1) / CELLWIDTH; m++)
 		for (n = 0; n < (area_height+CELLHEIGHT-1) / CELLHEIGHT; n++) {
 			if ((markmap[0][n] | markmap[1][n]) & (1 << m)) {
-				draw_cell(m, n);
+				int top = marktop[0][n][m] < marktop[1][n][m] ? marktop[0][n][m] : marktop[1][n][m];
+				int bottom = markbottom[0][n][m] > markbottom[1][n][m] ? markbottom[0][n][m] : markbottom[1][n][m];
+				draw_cell(m, n, top, bottom);
+				plot_cells_drawn++;
 				plot_tick();
 				if(plot_canceled)
 					return;
@@ -1581,10 +2037,44 @@ request_to_draw_cells_behind_numeric_input(void)
   redraw_request |= REDRAW_CELLS;
 }
 
+// the marker info text is laid out once per draw_all_cells() into this
+// list; each cell of the top area then draws only the items over it.
+#define INFO_ITEMS_MAX 24
+#define INFO_TEXT_MAX  384
+static struct {
+	int16_t x, y;
+	uint16_t width;
+	uint16_t color;
+	uint16_t text; // offset in info_text
+} info_item[INFO_ITEMS_MAX];
+static char info_text[INFO_TEXT_MAX];
+static int info_items = -1; // -1 until laid out
+static int info_text_len;
+
 static void
-cell_draw_marker_info(int x0, int y0)
+info_add(uint16_t color, const char *str, int x, int y)
+{
+	int len = strlen(str) + 1;
+	if (info_items >= INFO_ITEMS_MAX || info_text_len + len > INFO_TEXT_MAX)
+		return;
+	int width = 0;
+	for (const char *p = str; *p; p++)
+		width += FONT_GET_WIDTH((uint8_t)*p);
+	info_item[info_items].x = x;
+	info_item[info_items].y = y;
+	info_item[info_items].width = width;
+	info_item[info_items].color = color;
+	info_item[info_items].text = info_text_len;
+	memcpy(&info_text[info_text_len], str, len);
+	info_text_len += len;
+	info_items++;
+}
+
+static void
+marker_info_layout(void)
 {
 	char buf[24];
+	uint16_t fg = 0xFFFF;
 	int t;
 	if (active_marker == MARKER_INVALID)
 		return;
@@ -1596,12 +2086,12 @@ cell_draw_marker_info(int x0, int y0)
 		for (mk = 0; mk < MARKERS_MAX; mk++) {
 			if (!markers[mk].enabled)
 				continue;
-			ili9341_set_foreground(config.trace_color[t]);
-			int xpos = 1 + (j%2)*(WIDTH/2) + CELLOFFSETX - x0;
-			int ypos = 1 + (j/2)*(FONT_STR_HEIGHT) - y0;
+			fg = config.trace_color[t];
+			int xpos = 1 + (j%2)*(WIDTH/2) + CELLOFFSETX;
+			int ypos = 1 + (j/2)*(FONT_STR_HEIGHT);
 			strcpy(buf, " M1"); if (mk == active_marker) buf[0] = S_SARROW[0];
 			buf[2] += mk;
-			cell_drawstring(buf, xpos, ypos);
+			info_add(fg, buf, xpos, ypos);
 			xpos += 3*FONT_WIDTH + 3;
 			//trace_get_info(t, buf, sizeof buf);
 			freqHz_t freq = freqAt(markers[mk].index);
@@ -1611,27 +2101,27 @@ cell_draw_marker_info(int x0, int y0)
 			} else {
 				frequency_string_short(buf, sizeof buf, freq, 0);
 			}
-			cell_drawstring(buf, xpos, ypos);
+			info_add(fg, buf, xpos, ypos);
 			xpos += 11*FONT_WIDTH + 11;
 			if (uistat.marker_delta && mk != active_marker)
-				trace_get_value_string_delta(t, buf, sizeof buf, measured[trace[t].channel], markers[mk].index, markers[active_marker].index);
+				trace_get_value_string_delta(t, buf, sizeof buf, trace_src(t, measured[trace[t].channel]), markers[mk].index, markers[active_marker].index);
 			else
-				trace_get_value_string(t, buf, sizeof buf, measured[trace[t].channel], markers[mk].index);
-			ili9341_set_foreground(0xFFFF);
-			cell_drawstring(buf, xpos, ypos);
+				trace_get_value_string(t, buf, sizeof buf, trace_src(t, measured[trace[t].channel]), markers[mk].index);
+			fg = 0xFFFF;
+			info_add(fg, buf, xpos, ypos);
 			j++;
 		}
 
 		// draw marker delta
 		if (!uistat.marker_delta && active_marker != previous_marker) {
 			int idx0 = markers[previous_marker].index;
-			int xpos = (WIDTH/2+30) + CELLOFFSETX - x0;
-			int ypos = 1 + (j/2)*(FONT_STR_HEIGHT) - y0;
+			int xpos = (WIDTH/2+30) + CELLOFFSETX;
+			int ypos = 1 + (j/2)*(FONT_STR_HEIGHT);
 			strcpy(buf, S_DELTA "1-1:"); if (mk == active_marker) buf[0] = S_SARROW[0];
 			buf[1] += active_marker;
 			buf[3] += previous_marker;
-			ili9341_set_foreground(0xFFFF);
-			cell_drawstring(buf, xpos, ypos);
+			fg = 0xFFFF;
+			info_add(fg, buf, xpos, ypos);
 			xpos += 5*FONT_WIDTH + 5;
 			if ((domain_mode & DOMAIN_MODE) == DOMAIN_FREQ) {
 				frequency_string(buf, sizeof buf, freqAt(idx) - freqAt(idx0));
@@ -1642,37 +2132,40 @@ cell_draw_marker_info(int x0, int y0)
 				buf[n++] = ' ';
 				string_value_with_prefix(&buf[n], sizeof buf - n, distance_of_index(idx) - distance_of_index(idx0), 'm');
 			}
-			cell_drawstring(buf, xpos, ypos);
+			info_add(fg, buf, xpos, ypos);
 		}
 	} else {
 		for (t = 0; t < TRACES_MAX; t++) {
 			if (!trace[t].enabled)
 				continue;
-			int xpos = 1 + (j%2)*(WIDTH/2) + CELLOFFSETX - x0;
-			int ypos = 1 + (j/2)*(FONT_STR_HEIGHT) - y0;
+			int xpos = 1 + (j%2)*(WIDTH/2) + CELLOFFSETX;
+			int ypos = 1 + (j/2)*(FONT_STR_HEIGHT);
 			strcpy(buf, " CH0"); if (t == uistat.current_trace) buf[0] = S_SARROW[0];
 			buf[3] += trace[t].channel;
-			ili9341_set_foreground(config.trace_color[t]);
+			// math traces are labeled ME0 (memory), D-0 and D/0
+			static const char math_label[][3] = { "CH", "ME", "D-", "D/" };
+			memcpy(&buf[1], math_label[trace_src(t, measured[trace[t].channel]).math], 2);
+			fg = config.trace_color[t];
 			//chsnprintf(buf, sizeof buf, "CH%d", trace[t].channel);
-			cell_drawstring(buf, xpos, ypos); // invert
+			info_add(fg, buf, xpos, ypos);
 			xpos += 4*FONT_WIDTH + 4;
 			trace_get_info(t, buf, sizeof buf);
-			cell_drawstring(buf, xpos, ypos);
+			info_add(fg, buf, xpos, ypos);
 			xpos += 11*FONT_WIDTH + 5;
-			trace_get_value_string(t, buf, sizeof buf, measured[trace[t].channel], idx);
-			ili9341_set_foreground(0xFFFF);
-			cell_drawstring(buf, xpos, ypos);
+			trace_get_value_string(t, buf, sizeof buf, trace_src(t, measured[trace[t].channel]), idx);
+			fg = 0xFFFF;
+			info_add(fg, buf, xpos, ypos);
 			j++;
 		}
 
 		// draw marker frequency
-		int xpos = (WIDTH/2+40) + CELLOFFSETX - x0;
-		int ypos = 1 + (j/2)*(FONT_STR_HEIGHT) - y0;
+		int xpos = (WIDTH/2+40) + CELLOFFSETX;
+		int ypos = 1 + (j/2)*(FONT_STR_HEIGHT);
 		strcpy(buf, " 1:");if (uistat.lever_mode == LM_MARKER) buf[0] = S_SARROW[0];
 		buf[0] += active_marker;
 		xpos += FONT_WIDTH;
-		ili9341_set_foreground(0xFFFF);
-		cell_drawstring(buf, xpos, ypos);
+		fg = 0xFFFF;
+		info_add(fg, buf, xpos, ypos);
 		xpos += 3*FONT_WIDTH;
 		if ((domain_mode & DOMAIN_MODE) == DOMAIN_FREQ) {
 			frequency_string(buf, sizeof buf, plot_getFrequencyAt(idx));
@@ -1682,22 +2175,47 @@ cell_draw_marker_info(int x0, int y0)
 			buf[n++] = ' ';
 			string_value_with_prefix(&buf[n], sizeof buf-n, distance_of_index(idx), 'm');
 		}
-		cell_drawstring(buf, xpos, ypos);
+		info_add(fg, buf, xpos, ypos);
 	}
 	if (electrical_delay != 0) {
 		// draw electrical delay
-		int xpos = 21 + CELLOFFSETX - x0;
-		int ypos = 1 + ((j+1)/2)*(FONT_STR_HEIGHT) - y0;
+		int xpos = 21 + CELLOFFSETX;
+		int ypos = 1 + ((j+1)/2)*(FONT_STR_HEIGHT);
 		chsnprintf(buf, sizeof buf, "Edelay");
-		ili9341_set_foreground(0xFFFF);
-		cell_drawstring(buf, xpos, ypos);
+		fg = 0xFFFF;
+		info_add(fg, buf, xpos, ypos);
 		xpos += 7*FONT_WIDTH + 7;
 		int n = string_value_with_prefix(buf, sizeof buf, electrical_delay * 1e-12, 's');
-		cell_drawstring(buf, xpos, ypos);
+		info_add(fg, buf, xpos, ypos);
 		xpos += n*FONT_WIDTH + n;
 		float light_speed_ps = 299792458e-12; //(m/ps)
 		string_value_with_prefix(buf, sizeof buf, electrical_delay * light_speed_ps * velocity_factor, 'm');
-		cell_drawstring(buf, xpos, ypos);
+		info_add(fg, buf, xpos, ypos);
+	}
+}
+
+// lay out the marker info again when it is next drawn
+static void
+marker_info_invalidate(void)
+{
+	info_items = -1;
+}
+
+static void
+cell_draw_marker_info(int x0, int y0)
+{
+	if (info_items < 0) {
+		info_items = 0;
+		info_text_len = 0;
+		marker_info_layout();
+	}
+	for (int i = 0; i < info_items; i++) {
+		int x = info_item[i].x - x0;
+		int y = info_item[i].y - y0;
+		if (x + info_item[i].width <= 0 || x >= CELLWIDTH)
+			continue;
+		ili9341_set_foreground(info_item[i].color);
+		cell_drawstring(&info_text[info_item[i].text], x, y);
 	}
 }
 
@@ -1820,6 +2338,14 @@ draw_frequencies(void)
 			frequency_string(buf+4, 24-4, frequency0);
 			ili9341_drawstring(buf, FREQUENCIES_XPOS1, FREQUENCIES_YPOS);
 		}
+	} else if (td_zoom_active()) {
+		strcpy(buf, " START ");
+		string_value_with_prefix(buf+7, 24-7, td_zoom_start, 's');
+		ili9341_drawstring(buf, FREQUENCIES_XPOS1, FREQUENCIES_YPOS);
+
+		strcpy(buf, " STOP ");
+		string_value_with_prefix(buf+6, 24-6, td_zoom_stop, 's');
+		ili9341_drawstring(buf, FREQUENCIES_XPOS2, FREQUENCIES_YPOS);
 	} else {
 		strcpy(buf, " START 0s");
 		ili9341_drawstring(buf, FREQUENCIES_XPOS1, FREQUENCIES_YPOS);
@@ -1838,7 +2364,7 @@ draw_cal_status(void)
   char c[3];
   ili9341_set_foreground(DEFAULT_CAL_INACTIVE_COLOR);
   ili9341_set_background(DEFAULT_BG_COLOR);
-  ili9341_fill(0, y, OFFSETX, 6*(FONT_STR_HEIGHT), DEFAULT_BG_COLOR);
+  ili9341_fill(0, y, OFFSETX, 7*(FONT_STR_HEIGHT), DEFAULT_BG_COLOR);
   if (cal_status & CALSTAT_APPLY) {
 	ili9341_set_foreground(DEFAULT_CAL_ACTIVE_COLOR);
     c[0] = cal_status & CALSTAT_INTERPOLATED ? 'c' : 'C';
@@ -1858,6 +2384,16 @@ draw_cal_status(void)
   for (i = 0; i < sizeof(calibration_text)/sizeof(*calibration_text); i++, y+=FONT_STR_HEIGHT)
     if (cal_status & calibration_text[i].mask)
       ili9341_drawstring(calibration_text[i].text, x, y);
+
+  // calibration collection progress in tens of percent; only one character
+  // fits in the left margin
+  int progress = calCollectProgress;
+  if (progress >= 0) {
+    c[0] = '0' + (progress >= 90 ? 9 : progress / 10);
+    c[1] = 0;
+    ili9341_set_foreground(DEFAULT_CAL_ACTIVE_COLOR);
+    ili9341_drawstring(c, x, y);
+  }
 }
 
 void
@@ -75,6 +75,12 @@ extern small_function<freqHz_t(int index)> plot_getFrequencyAt;
 // to process events in the event queue.
 extern small_function<void()> plot_tick;
 
+// number of cells drawn by draw_all_cells() since it was last cleared
+extern uint16_t plot_cells_drawn;
+
+// number of completed sweeps
+extern uint16_t sweep_count;
+
 void plot_init(void);
 
 // mark a cell for redraw. x: 0 to 15; y: 0 to 7
@@ -96,7 +102,21 @@ void request_to_redraw_marker(int marker);
 void redraw_marker(int marker);
 void trace_get_info(int t, char *buf, int len);
 float groupdelay_from_array(int i, complexf array[SWEEP_POINTS_MAX]);
+
+// trace math, per trace; applied while a memory of the trace's channel
+// exists for the current sweep.
+enum {
+	TRACE_MATH_OFF, TRACE_MATH_MEMORY, TRACE_MATH_SUB, TRACE_MATH_DIV
+};
+extern uint8_t trace_math[TRACES_MAX];
+// save the current data of a channel as its memory
+void trace_memory_store(int ch);
 void plot_into_index(complexf measured[2][SWEEP_POINTS_MAX]);
+// note that points from to to (inclusive) of measured[] changed
+void plot_points_changed(int from, int to);
+// like plot_into_index(), but only for the points changed since the last
+// plot; does nothing if no point changed.
+void plot_into_index_changed(complexf measured[2][SWEEP_POINTS_MAX]);
 void force_set_markmap(void);
 void draw_all(bool flush);
 void draw_all_cells(bool flush_markmap);
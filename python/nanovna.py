@@ -481,6 +481,65 @@ class NanoVNAV2(NanoVNA):
         arr = 0xFF000000 + ((arr & 0xF800) >> 8) + ((arr & 0x07E0) << 5) + ((arr & 0x001F) << 19)
         return Image.frombuffer('RGBA', (width, height), arr, 'raw', 'RGBA', 0, 1)
 
+    def frame_stats(self):
+        # statistics of the last frame the device drew: time in us,
+        # pixels written, plot cells drawn and a frame counter
+        self.open()
+        self.serial.write([0,0,0,0,0,0,0,0])
+        self.serial.write([0x12, 0xe0, 0x12, 0xe4, 0x11, 0xe8, 0x11, 0xea])
+        return struct.unpack('<IIHH', self.serial.read(12))
+
+    def capture_stream(self):
+        # yields the display each time the device has sent all pending
+        # updates; the device keeps running while streaming.
+        from PIL import Image
+
+        self.open()
+
+        # reset protocol to known state
+        self.serial.write([0,0,0,0,0,0,0,0])
+
+        self.serial.write([0x20, 0xef, 0x01])
+        self.serial.timeout = 10
+        width, height, pixel = struct.unpack('<HHB', self.serial.read(2 + 2 + 1))
+        screen = np.zeros((height, width), dtype=np.uint32)
+
+        # reads a record into screen; returns False at the end of the stream
+        def read_record():
+            t, x, y, w, h = struct.unpack('<BHHHH', self.serial.read(9))
+            if t == 0:
+                return False
+            if t == 1:
+                screen[y:y+h, x:x+w] = struct.unpack('>H', self.serial.read(2))[0]
+            elif t == 2:
+                px = []
+                while len(px) < w * h:
+                    n = self.serial.read(1)[0]
+                    if n < 0x80:
+                        px += struct.unpack('>%dH' % (n + 1), self.serial.read(2 * (n + 1)))
+                    else:
+                        px += struct.unpack('>H', self.serial.read(2)) * (n - 0x7e)
+                screen[y:y+h, x:x+w] = np.array(px, dtype=np.uint32).reshape(h, w)
+            else:
+                raise IOError("bad capture record type %d" % t)
+            return True
+
+        stopped = False
+        try:
+            while read_record():
+                if self.serial.in_waiting == 0:
+                    arr = screen
+                    arr = 0xFF000000 + ((arr & 0xF800) >> 8) + ((arr & 0x07E0) << 5) + ((arr & 0x001F) << 19)
+                    yield Image.frombuffer('RGBA', (width, height), arr, 'raw', 'RGBA', 0, 1)
+            stopped = True
+        finally:
+            if not stopped:
+                # the device ends the stream with a type 0 record; skip the
+                # updates sent before it
+                self.serial.write([0x20, 0xef, 0x00])
+                while read_record():
+                    pass
+
 
 
 
@@ -0,0 +1,74 @@
+#pragma once
+#include "common.hpp"
+
+// streaming equivalent of applying the [1 2 1] smoothing kernel nPasses
+// times over an array of complex values, using the same edge handling as
+// measurementDataSmooth() in main2.cpp ([2 1] at both ends).
+// values must be pushed in index order starting from index 0; each smoothed
+// value is emitted nPasses points after its input was pushed, and finish()
+// emits the remaining values once the last point has been pushed.
+// the cost of push() is one kernel evaluation per pass, independent of
+// the array length.
+template<int nPasses>
+class StreamSmoother {
+public:
+	// emit must have the signature:
+	// void(int index, complexf value)
+	template<class emit_t>
+	void push(complexf value, const emit_t& emit) {
+		feed(0, value, emit);
+	}
+
+	// flush all passes; call after the last point has been pushed.
+	template<class emit_t>
+	void finish(const emit_t& emit) {
+		for(int s = 0; s < nPasses; s++) {
+			Stage& st = stages[s];
+			if(st.count == 0)
+				continue;
+			complexf v = st.prev1;
+			if(st.count > 1)
+				v = (st.prev1 * 2.f + st.prev2) * (1.f/3.f);
+			st.count = 0;
+			feed(s + 1, v, emit);
+		}
+		outIndex = 0;
+	}
+
+	void reset() {
+		for(auto& st: stages)
+			st.count = 0;
+		outIndex = 0;
+	}
+
+private:
+	struct Stage {
+		complexf prev2, prev1;
+		// number of inputs received, saturates at 2
+		uint8_t count = 0;
+	};
+	Stage stages[nPasses];
+	int outIndex = 0;
+
+	// push a value into pass s; every pass delays its input by one point.
+	template<class emit_t>
+	void feed(int s, complexf v, const emit_t& emit) {
+		for(; s < nPasses; s++) {
+			Stage& st = stages[s];
+			complexf u = v;
+			if(st.count == 0) {
+				st.prev1 = u;
+				st.count = 1;
+				return;
+			}
+			if(st.count == 1)
+				v = (st.prev1 * 2.f + u) * (1.f/3.f);
+			else
+				v = (st.prev2 + st.prev1 * 2.f + u) * 0.25f;
+			st.prev2 = st.prev1;
+			st.prev1 = u;
+			st.count = 2;
+		}
+		emit(outIndex++, v);
+	}
+};
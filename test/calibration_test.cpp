@@ -0,0 +1,174 @@
+// host test and benchmark of the correction math in calibration.hpp.
+// synthetic raw measurements are generated from known error boxes; the
+// correction has to recover the DUT, in double to rounding error and in
+// float to the precision the firmware needs. the float instantiation is
+// also compared against the inline correction processDataPoint() did
+// before SOLT_apply_correction() existed.
+#include "calibration.hpp"
+#include "check.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <chrono>
+
+typedef complex<double> complexd;
+
+// error model: 1 port error box plus thru leakage linear in the reflected
+// wave and a transmission tracking term, as assumed by the firmware.
+struct errorBox {
+	complexd e00, e11, e10e01;	// directivity, source match, reflection tracking
+	complexd leak, leak_r;		// thru leakage: leak + leak_r * raw reflection
+	complexd et;			// transmission tracking
+};
+
+static complexd rawRefl(const errorBox& e, complexd s11) {
+	return e.e00 + e.e10e01 * s11 / (1. - e.e11 * s11);
+}
+
+static complexd rawThru(const errorBox& e, complexd s11, complexd s21) {
+	return e.leak + e.leak_r * rawRefl(e, s11) + e.et * s21 / (1. - e.e11 * s11);
+}
+
+static double frand(double lo, double hi) {
+	return lo + (hi - lo) * rand() / RAND_MAX;
+}
+
+static complexd crand(double r) {
+	return polar(frand(0, r), frand(-M_PI, M_PI));
+}
+
+static errorBox randomBox() {
+	errorBox e;
+	e.e00 = crand(0.3);
+	e.e11 = crand(0.3);
+	e.e10e01 = polar(frand(0.3, 1.5), frand(-M_PI, M_PI));
+	e.leak = crand(1e-3);
+	e.leak_r = crand(1e-3);
+	e.et = polar(frand(0.1, 1.5), frand(-M_PI, M_PI));
+	return e;
+}
+
+// calibration data of one point for error box e; the thru standard is a
+// through line with a slightly mismatched port 2 (s11 = thruRefl)
+template<class C>
+static array<C, CAL_ENTRIES> calData(const errorBox& e, complexd thruRefl) {
+	array<complexd, CAL_ENTRIES> cal;
+	cal[CAL_LOAD] = rawRefl(e, 0.);
+	cal[CAL_OPEN] = rawRefl(e, 1.);
+	cal[CAL_SHORT] = rawRefl(e, -1.);
+	cal[CAL_ISOLN_OPEN] = rawThru(e, 1., 0.);
+	cal[CAL_ISOLN_SHORT] = rawThru(e, -1., 0.);
+	cal[CAL_THRU] = rawThru(e, thruRefl, 1.);
+	cal[CAL_THRU_REFL] = rawRefl(e, thruRefl);
+	array<C, CAL_ENTRIES> ret;
+	for(int i = 0; i < CAL_ENTRIES; i++)
+		ret[i] = C(cal[i]);
+	return ret;
+}
+
+// the correction as processDataPoint() did it inline before it was moved
+// into SOLT_apply_correction()
+static void baselineCorrection(const array<complexf, CAL_ENTRIES>& cal, bool thruCal,
+								bool enhancedResponse, complexf& refl, complexf& thru) {
+	// apply thru leakage correction
+	auto x1 = cal[CAL_SHORT],
+		y1 = cal[CAL_ISOLN_SHORT],
+		x2 = cal[CAL_OPEN],
+		y2 = cal[CAL_ISOLN_OPEN];
+	auto cal_thru_leak_r = (y1-y2)/(x1-x2);
+	auto cal_thru_leak = y2-cal_thru_leak_r*x2;
+	thru = thru - (cal_thru_leak + refl*cal_thru_leak_r);
+
+	// calculate reflection
+	auto newRefl = SOL_compute_reflection(cal[CAL_SHORT], cal[CAL_OPEN], cal[CAL_LOAD], refl);
+
+	// apply thru response correction
+	if(thruCal) {
+		auto refThru = cal[CAL_THRU];
+		auto reflThru = cal[CAL_THRU_REFL];
+		refThru = refThru - (cal_thru_leak + reflThru*cal_thru_leak_r);
+		reflThru = SOL_compute_reflection(cal[CAL_SHORT], cal[CAL_OPEN], cal[CAL_LOAD], reflThru);
+		auto thruGain = SOL_compute_thru_gain(cal[CAL_SHORT], cal[CAL_OPEN], cal[CAL_LOAD], newRefl);
+		auto refThruGain = SOL_compute_thru_gain(cal[CAL_SHORT], cal[CAL_OPEN], cal[CAL_LOAD], reflThru);
+
+		if(enhancedResponse)
+			refThru *= thruGain / refThruGain;
+
+		thru = thru / refThru;
+	}
+
+	refl = newRefl;
+}
+
+static void testCoefficients() {
+	double errD = 0;
+	for(int n = 0; n < 10000; n++) {
+		errorBox e = randomBox();
+		auto c = SOL_compute_coefficients(rawRefl(e, -1.), rawRefl(e, 1.), rawRefl(e, 0.));
+		complexd dut = crand(1);
+		complexd raw = rawRefl(e, dut);
+		errD = max(errD, abs(SOL_compute_reflection(c, raw) - dut));
+		errD = max(errD, abs(SOL_compute_reflection(rawRefl(e, -1.), rawRefl(e, 1.),
+			rawRefl(e, 0.), raw) - dut));
+	}
+	check(errD < 1e-9, "SOL reflection, double vs exact", errD, 1e-9);
+}
+
+static void testCorrection() {
+	double errD = 0, errF = 0, errBase = 0;
+	for(int n = 0; n < 10000; n++) {
+		errorBox e = randomBox();
+		complexd thruRefl = crand(0.05);
+		complexd s11 = crand(1), s21 = crand(1);
+		complexd reflD = rawRefl(e, s11), thruD = rawThru(e, s11, s21);
+		complexf reflF = complexf(reflD), thruF = complexf(thruD);
+		complexf reflB = reflF, thruB = thruF;
+
+		SOLT_apply_correction(calData<complexd>(e, thruRefl), true, true, reflD, thruD);
+		SOLT_apply_correction(calData<complexf>(e, thruRefl), true, true, reflF, thruF);
+		baselineCorrection(calData<complexf>(e, thruRefl), true, true, reflB, thruB);
+
+		errD = max(errD, max(abs(reflD - s11), abs(thruD - s21)));
+		errF = max(errF, max(abs(complexd(reflF) - s11), abs(complexd(thruF) - s21)));
+		errBase = max(errBase, (double) max(abs(reflF - reflB), abs(thruF - thruB)));
+	}
+	check(errD < 1e-9, "full correction, double vs exact", errD, 1e-9);
+	check(errF < 1e-4, "full correction, float vs exact", errF, 1e-4);
+	check(errBase == 0, "full correction, float vs baseline code", errBase, 0);
+}
+
+// time per point of SOLT_apply_correction with thru and enhanced response
+template<class C>
+static double benchCorrection() {
+	constexpr int points = 201;
+	static array<C, CAL_ENTRIES> cal[points];
+	static C refl[points], thru[points];
+	for(int i = 0; i < points; i++) {
+		errorBox e = randomBox();
+		cal[i] = calData<C>(e, 0.01);
+		refl[i] = C(rawRefl(e, 0.5));
+		thru[i] = C(rawThru(e, 0.5, 0.7));
+	}
+	int rounds = 2000;
+	C sum = 0;
+	auto t0 = chrono::steady_clock::now();
+	for(int r = 0; r < rounds; r++) {
+		for(int i = 0; i < points; i++) {
+			C a = refl[i], b = thru[i];
+			SOLT_apply_correction(cal[i], true, true, a, b);
+			sum += a + b;
+		}
+	}
+	auto t1 = chrono::steady_clock::now();
+	if(sum == C(12345))
+		printf(" ");
+	return chrono::duration<double, nano>(t1 - t0).count() / (rounds * points);
+}
+
+int main() {
+	srand(1);
+	testCoefficients();
+	testCorrection();
+	printf("%-44s %10.1f ns\n", "SOLT_apply_correction per point, float", benchCorrection<complexf>());
+	printf("%-44s %10.1f ns\n", "SOLT_apply_correction per point, double", benchCorrection<complexd>());
+	return failures ? 1 : 0;
+}
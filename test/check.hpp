@@ -0,0 +1,12 @@
+// result reporting shared by the host tests: each check prints one line
+// with the measured value and its limit, and main() returns failures != 0.
+#pragma once
+#include <stdio.h>
+
+static int failures = 0;
+
+static void check(bool ok, const char* what, double value, double limit) {
+	printf("%-44s %10.3g (limit %g)%s\n", what, value, limit, ok ? "" : "  FAIL");
+	if(!ok)
+		failures++;
+}
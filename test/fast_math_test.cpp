@@ -0,0 +1,46 @@
+// host accuracy test of the approximations in fast_math.hpp against libm
+// in double precision. the limits are the maximum errors stated in the
+// header; the plotted trace values rely on them.
+#include "fast_math.hpp"
+#include "check.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+
+int main() {
+	std::mt19937 rng(1);
+	// uniform in the exponent, so that all binades are covered
+	std::uniform_real_distribution<double> expo(-140, 120);
+	std::uniform_real_distribution<double> angle(-M_PI, M_PI);
+	std::uniform_real_distribution<double> radius(0, 1e3);
+	constexpr int N = 5000000;
+
+	double errLog2 = 0, errLog10 = 0, errSqrt = 0, errRsqrt = 0, errAtan2 = 0;
+	for(int n = 0; n < N; n++) {
+		float x = (float) pow(2., expo(rng));
+		if(!(x > 0))
+			continue;
+		errLog2 = fmax(errLog2, fabs(fast_log2f(x) - log2((double) x)));
+		errLog10 = fmax(errLog10, fabs(fast_log10f(x) - log10((double) x)));
+		if(x >= 1.17549435e-38f) {
+			double s = sqrt((double) x);
+			errSqrt = fmax(errSqrt, fabs(fast_sqrtf(x) - s) / s);
+			errRsqrt = fmax(errRsqrt, fabs(fast_rsqrtf(x) * s - 1));
+		}
+		double a = angle(rng), r = radius(rng);
+		float y = (float)(r * sin(a)), z = (float)(r * cos(a));
+		errAtan2 = fmax(errAtan2, fabs(fast_atan2f(y, z) - atan2((double) y, (double) z)));
+	}
+	check(errLog2 < 3e-5, "fast_log2f, absolute", errLog2, 3e-5);
+	check(errLog10 < 1.5e-5, "fast_log10f, absolute", errLog10, 1.5e-5);
+	check(errAtan2 < 5e-6, "fast_atan2f, absolute (rad)", errAtan2, 5e-6);
+	check(errRsqrt < 5e-6, "fast_rsqrtf, relative", errRsqrt, 5e-6);
+	check(errSqrt < 5e-6, "fast_sqrtf, relative", errSqrt, 5e-6);
+
+	// special cases kept from libm
+	bool special = fast_log2f(0) == -INFINITY && fast_log2f(-1) == -INFINITY
+		&& fast_atan2f(0, 0) == 0 && fast_atan2f(0, -1) == (float) M_PI
+		&& fast_sqrtf(0) == 0;
+	check(special, "special cases, mismatches", special ? 0 : 1, 0);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,112 @@
+// host accuracy test of fft.cpp against a double precision DFT.
+// built twice by the Makefile: fft_test with the float core and
+// fft_q31_test with FFT_FIXED_POINT=1, the path of the no-FPU build.
+#include "fft.hpp"
+#include "common.hpp"
+#include "check.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+
+typedef complex<double> complexd;
+
+static std::mt19937 rng(1);
+
+// sum_k x[k] exp(sign * 2 pi j k m / FFT_SIZE)
+static void dft(const complexd* x, complexd* X, int sign) {
+	for(int m = 0; m < FFT_SIZE; m++) {
+		complexd s = 0;
+		for(int k = 0; k < FFT_SIZE; k++)
+			s += x[k] * polar(1., sign * 2 * M_PI * (double)((k * m) % FFT_SIZE) / FFT_SIZE);
+		X[m] = s;
+	}
+}
+
+// largest error relative to the largest output magnitude
+static double relError(const float (*a)[2], const complexd* ref, int n) {
+	double err = 0, mag = 0;
+	for(int i = 0; i < n; i++) {
+		err = fmax(err, abs(complexd(a[i][0], a[i][1]) - ref[i]));
+		mag = fmax(mag, abs(ref[i]));
+	}
+	return err / mag;
+}
+
+static void testTransform(int dir, double level) {
+	static float a[FFT_SIZE][2];
+	static complexd x[FFT_SIZE], X[FFT_SIZE];
+	std::normal_distribution<double> noise(0, level);
+	double err = 0;
+	for(int n = 0; n < 20; n++) {
+		for(int i = 0; i < FFT_SIZE; i++) {
+			a[i][0] = (float) noise(rng);
+			a[i][1] = (float) noise(rng);
+			x[i] = complexd(a[i][0], a[i][1]);
+		}
+		dft(x, X, dir ? 1 : -1);
+		fft(a, dir);
+		err = fmax(err, relError(a, X, FFT_SIZE));
+	}
+	char what[64];
+	snprintf(what, sizeof(what), "%s, level %g", dir ? "fft_inverse" : "fft_forward", level);
+	check(err < 1e-5, what, err, 1e-5);
+}
+
+static void testInverseReal() {
+	static float a[FFT_SIZE][2];
+	static complexd X[FFT_SIZE], x[FFT_SIZE];
+	std::normal_distribution<double> noise(0, 1);
+	double err = 0, mag = 0;
+	for(int n = 0; n < 20; n++) {
+		// hermitian spectrum
+		for(int k = 0; k <= FFT_SIZE/2; k++) {
+			X[k] = complexd(noise(rng), (k == 0 || k == FFT_SIZE/2) ? 0 : noise(rng));
+			X[(FFT_SIZE - k) % FFT_SIZE] = conj(X[k]);
+			a[k][0] = (float) X[k].real();
+			a[k][1] = (float) X[k].imag();
+		}
+		dft(X, x, 1);
+		fft_inverse_real(a);
+		const float* r = (const float*) a;
+		for(int i = 0; i < FFT_SIZE; i++) {
+			err = fmax(err, fabs(r[i] - x[i].real()));
+			mag = fmax(mag, abs(x[i]));
+		}
+	}
+	check(err / mag < 1e-5, "fft_inverse_real", err / mag, 1e-5);
+}
+
+static void testCzt() {
+	constexpr int n = 201, count = 201;
+	static float in[n][2], weight[n], out[count][2], work[FFT_SIZE][2], filter[FFT_SIZE][2];
+	static complexd ref[count];
+	std::normal_distribution<double> noise(0, 1);
+	for(int k = 0; k < n; k++) {
+		in[k][0] = (float) noise(rng);
+		in[k][1] = (float) noise(rng);
+		weight[k] = (float)(0.5 - 0.5 * cos(2 * M_PI * (k + 0.5) / n));
+	}
+	const float theta = 0.3f, phi = 0.01f;
+	for(int m = 0; m < count; m++) {
+		complexd s = 0;
+		for(int k = 0; k < n; k++)
+			s += complexd(in[k][0], in[k][1]) * (double) weight[k]
+				* polar(1., k * ((double) theta + m * (double) phi));
+		ref[m] = s;
+	}
+	czt_prepare(filter, n, phi);
+	czt(in, weight, n, out, count, theta, phi, work, filter);
+	double err = relError(out, ref, count);
+	check(err < 1e-4, "czt, 201 points", err, 1e-4);
+}
+
+int main() {
+	printf("FFT_SIZE %d, %s core\n", FFT_SIZE, FFT_FIXED_POINT ? "q31" : "float");
+	for(double level: {1e-6, 1., 1e4}) {
+		testTransform(0, level);
+		testTransform(1, level);
+	}
+	testInverseReal();
+	testCzt();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,17 @@
+#pragma once
+// host stand-in for the board headers: enough for the drawing code
+// (plot.cpp, ili9341.cpp, globals.cpp) to build into the host tests.
+#include <mculib/fastwiring.hpp>
+#include "common.hpp"
+
+#define BOARD_NAME "host"
+#define BOARD_REVISION 2
+#define USB_POINTS_MAX 1024
+#define BOARD_MEASUREMENT_NPERIODS_NORMAL		14
+#define BOARD_MEASUREMENT_NPERIODS_CALIBRATING	30
+#define BOARD_MEASUREMENT_ECAL_INTERVAL			 5
+#define BOARD_MEASUREMENT_NWAIT_SWITCH			 1
+
+namespace board {
+	static inline void ledPulse() {}
+}
@@ -0,0 +1,24 @@
+// the definitions the drawing code takes from main2.cpp, ui.cpp and mculib,
+// for the host tests that build plot.cpp without them.
+#include <stdarg.h>
+#include <stdio.h>
+#include "globals.hpp"
+#include <mculib/printf.hpp>
+
+int8_t previous_marker = MARKER_INVALID;
+
+int mculib::hostPadLevel[64];
+
+int chsnprintf(char *str, size_t size, const char *fmt, ...) {
+	va_list ap;
+	va_start(ap, fmt);
+	int ret = vsnprintf(str, size, fmt, ap);
+	va_end(ap);
+	return ret;
+}
+
+// no time domain transform on the host
+td_key_t td_key_current() {
+	td_key_t key = {current_props._sweep_points};
+	return key;
+}
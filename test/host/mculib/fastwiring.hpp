@@ -0,0 +1,12 @@
+#pragma once
+#include <stdint.h>
+
+namespace mculib {
+	typedef int Pad;
+	enum { LOW = 0, HIGH = 1 };
+	// level last written to each pad, for the host panel emulation
+	extern int hostPadLevel[64];
+	static inline void digitalWrite(Pad p, int v) { hostPadLevel[p & 63] = v; }
+	static inline void delay(int ms) {}
+}
+using namespace mculib;
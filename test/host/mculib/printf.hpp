@@ -0,0 +1,4 @@
+#pragma once
+#include <stddef.h>
+
+int chsnprintf(char *str, size_t size, const char *fmt, ...);
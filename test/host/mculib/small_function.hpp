@@ -0,0 +1,4 @@
+#pragma once
+#include <functional>
+
+template<class T> using small_function = std::function<T>;
@@ -0,0 +1,212 @@
+// host test of the cell drawing primitives of plot.cpp: blend_rgb565(),
+// cell_blend_pixel() and the anti-aliased cell_drawline(). plot.cpp is
+// included so that its static functions can be called; the rest of the
+// firmware it refers to comes from ../globals.cpp, ../ili9341.cpp and
+// host/host.cpp.
+#include "plot.cpp"
+#include "check.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <random>
+
+static std::mt19937 rng(1);
+
+// field of a pixel in panel byte order: 0 red, 1 green, 2 blue
+static int field(uint16_t c, int f) {
+	c = byteReverse16(c);
+	switch(f) {
+	case 0: return c >> 11;
+	case 1: return (c >> 5) & 63;
+	default: return c & 31;
+	}
+}
+
+// every field has to be within one LSB of the exact blend, and alpha 0
+// and 32 have to give bg and fg unchanged.
+static void testBlend() {
+	std::uniform_int_distribution<int> color(0, 0xffff);
+	double err = 0;
+	int endpointErrors = 0;
+	for(int n = 0; n < 300000; n++) {
+		uint16_t bg = color(rng), fg = color(rng);
+		if(n < 4) {
+			bg = (n & 1) ? 0xffff : 0;
+			fg = (n & 2) ? 0xffff : 0;
+		}
+		for(int alpha = 0; alpha <= 32; alpha++) {
+			uint16_t c = blend_rgb565(bg, fg, alpha);
+			for(int f = 0; f < 3; f++) {
+				double exact = field(bg, f) + (field(fg, f) - field(bg, f)) * alpha / 32.;
+				err = fmax(err, fabs(field(c, f) - exact));
+			}
+		}
+		endpointErrors += blend_rgb565(bg, fg, 0) != bg;
+		endpointErrors += blend_rgb565(bg, fg, 32) != fg;
+	}
+	check(err < 1, "blend_rgb565, per field (LSB)", err, 1);
+	check(endpointErrors == 0, "blend_rgb565, alpha 0 and 32 mismatches", endpointErrors, 0);
+}
+
+static uint16_t* cell() { return ili9341_spi_buffer; }
+
+static void clearCell() {
+	memset(ili9341_spi_buffer, 0, CELLWIDTH * CELLHEIGHT * sizeof(uint16_t));
+}
+
+// blending outside the cell or with alpha 0 must not touch the buffer
+static void testBlendPixel() {
+	uint16_t* buf = ili9341_spi_buffer;
+	for(int i = 0; i < SPI_BUFFER_SIZE * 2; i++)
+		ili9341_spi_buffers[i] = 0x1234;
+	for(int i = -1; i <= CELLWIDTH; i++) {
+		cell_blend_pixel(i, -1, 0xffff, 32);
+		cell_blend_pixel(i, CELLHEIGHT, 0xffff, 32);
+		cell_blend_pixel(-1, i, 0xffff, 32);
+		cell_blend_pixel(CELLWIDTH, i, 0xffff, 32);
+		cell_blend_pixel(i, 3, 0xffff, 0);
+	}
+	int changed = 0;
+	for(int i = 0; i < SPI_BUFFER_SIZE * 2; i++)
+		changed += ili9341_spi_buffers[i] != 0x1234;
+	check(changed == 0, "cell_blend_pixel, pixels changed by clipping", changed, 0);
+
+	cell_blend_pixel(5, 7, 0xffff, 32);
+	changed = 0;
+	for(int i = 0; i < SPI_BUFFER_SIZE * 2; i++)
+		changed += ili9341_spi_buffers[i] != 0x1234;
+	bool ok = changed == 1 && buf[7 * CELLWIDTH + 5] == 0xffff;
+	check(ok, "cell_blend_pixel, pixels changed by (5, 7)", changed, 1);
+}
+
+// lines drawn in white on black. pixel centers are at integer pixel
+// coordinates, segment ends in INDEX_FRAC fixed point.
+// - every lit pixel is between the rounded end points on the major axis
+//   and less than a pixel from the line on the minor axis, give or take
+//   the 1/32 pixel resolution of the alpha
+// - along the major axis each step lights one pixel's worth: the two
+//   pixels straddling the line sum to full intensity, less the rounding
+//   of the two blends
+// - the intensity weighted center of each step is on the line
+static void testDrawline() {
+	const int one = 1 << INDEX_FRAC;
+	std::uniform_int_distribution<int> coord(-4 * one, (CELLWIDTH + 4) * one);
+	double maxDistance = 0, maxCenterError = 0;
+	int coverageErrors = 0, outside = 0;
+	for(int n = 0; n < 20000; n++) {
+		int x0 = coord(rng), y0 = coord(rng), x1 = coord(rng), y1 = coord(rng);
+		clearCell();
+		cell_drawline(x0, y0, x1, y1, 0xffff, true);
+		double ax = x0 / (double) one, ay = y0 / (double) one;
+		double bx = x1 / (double) one, by = y1 / (double) one;
+		bool steep = abs(y1 - y0) > abs(x1 - x0);
+		for(int y = 0; y < CELLHEIGHT; y++)
+			for(int x = 0; x < CELLWIDTH; x++) {
+				if(!cell()[y * CELLWIDTH + x])
+					continue;
+				int major = steep ? y : x;
+				double minor = steep ? x : y;
+				double a0 = steep ? ay : ax, a1 = steep ? by : bx;
+				double b0 = steep ? ax : ay, b1 = steep ? bx : by;
+				if(major < lround(fmin(a0, a1)) || major > lround(fmax(a0, a1)) || a0 == a1) {
+					outside++;
+					continue;
+				}
+				double ideal = b0 + (major - a0) / (a1 - a0) * (b1 - b0);
+				maxDistance = fmax(maxDistance, fabs(minor - ideal));
+			}
+		// steps along the major axis strictly inside the segment whose
+		// minor axis pixels are both inside the cell
+		int lo = (int) ceil(fmin(steep ? ay : ax, steep ? by : bx)) + 1;
+		int hi = (int) floor(fmax(steep ? ay : ax, steep ? by : bx)) - 1;
+		for(int m = lo; m <= hi; m++) {
+			if(m < 0 || m >= (steep ? CELLHEIGHT : CELLWIDTH))
+				continue;
+			double t = steep ? (m - ay) / (by - ay) : (m - ax) / (bx - ax);
+			double ideal = steep ? ax + t * (bx - ax) : ay + t * (by - ay);
+			int mi = (int) floor(ideal);
+			if(mi < 0 || mi + 1 >= (steep ? CELLWIDTH : CELLHEIGHT))
+				continue;
+			double sum = 0, moment = 0;
+			for(int k = 0; k < (steep ? CELLWIDTH : CELLHEIGHT); k++) {
+				uint16_t p = steep ? cell()[m * CELLWIDTH + k] : cell()[k * CELLWIDTH + m];
+				int g = field(p, 1);
+				sum += g;
+				moment += g * k;
+			}
+			if(sum < 61 || sum > 63)
+				coverageErrors++;
+			if(sum > 0)
+				maxCenterError = fmax(maxCenterError, fabs(moment / sum - ideal));
+		}
+	}
+	check(outside == 0, "cell_drawline, lit pixels past the end points", outside, 0);
+	check(maxDistance < 1 + 1/32., "cell_drawline, lit pixel to line (px)", maxDistance, 1 + 1/32.);
+	check(coverageErrors == 0, "cell_drawline, steps not at full intensity", coverageErrors, 0);
+	check(maxCenterError <= 0.1, "cell_drawline, step center to line (px)", maxCenterError, 0.1);
+}
+
+// a cell drawn from another origin, as draw_cell() does for the rows it
+// redraws, has to show the same pixels where the two overlap; otherwise
+// partial redraws leave pixels that a full redraw would not.
+static void testCellOffset() {
+	const int one = 1 << INDEX_FRAC;
+	static uint16_t ref[CELLHEIGHT][CELLWIDTH];
+	std::uniform_int_distribution<int> coord(-4 * one, (CELLWIDTH + 4) * one);
+	std::uniform_int_distribution<int> shift(-CELLHEIGHT + 1, CELLHEIGHT - 1);
+	int mismatches = 0;
+	for(int n = 0; n < 50000; n++) {
+		int x0 = coord(rng), y0 = coord(rng), x1 = coord(rng), y1 = coord(rng);
+		int sx = shift(rng), sy = shift(rng);
+		clearCell();
+		cell_drawline(x0, y0, x1, y1, 0xffff, false);
+		memcpy(ref, cell(), sizeof(ref));
+		clearCell();
+		cell_drawline(x0 - sx * one, y0 - sy * one, x1 - sx * one, y1 - sy * one, 0xffff, false);
+		for(int y = 0; y < CELLHEIGHT; y++)
+			for(int x = 0; x < CELLWIDTH; x++) {
+				if(x + sx < 0 || x + sx >= CELLWIDTH || y + sy < 0 || y + sy >= CELLHEIGHT)
+					continue;
+				mismatches += cell()[y * CELLWIDTH + x] != ref[y + sy][x + sx];
+			}
+	}
+	check(mismatches == 0, "cell_drawline, pixels depending on cell origin", mismatches, 0);
+}
+
+// a polyline drawn as the traces are, with last set only on the final
+// segment, lights every column once: no column may be blended twice
+// where two segments join.
+static void testJoins() {
+	const int one = 1 << INDEX_FRAC;
+	std::uniform_int_distribution<int> step(one / 2, 4 * one);
+	std::uniform_int_distribution<int> rise(-one, one);
+	int overlaps = 0;
+	for(int n = 0; n < 2000; n++) {
+		clearCell();
+		int x = -2 * one, y = (CELLHEIGHT / 2) * one;
+		while(x < (CELLWIDTH + 2) * one) {
+			int dx = step(rng);
+			int dy = rise(rng) * dx / one / 2; // shallow, so x stays the major axis
+			bool last = x + dx >= (CELLWIDTH + 2) * one;
+			cell_drawline(x, y, x + dx, y + dy, 0xffff, last);
+			x += dx;
+			y += dy;
+		}
+		for(int cx = 0; cx < CELLWIDTH; cx++) {
+			int sum = 0;
+			for(int cy = 0; cy < CELLHEIGHT; cy++)
+				sum += field(cell()[cy * CELLWIDTH + cx], 1);
+			if(sum > 63)
+				overlaps++;
+		}
+	}
+	check(overlaps == 0, "cell_drawline, columns blended twice at joins", overlaps, 0);
+}
+
+int main() {
+	testBlend();
+	testBlendPixel();
+	testDrawline();
+	testCellOffset();
+	testJoins();
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,454 @@
+// host renderer: replays sweeps through the plotting code into an emulated
+// panel and reports, per trace format, the plot cells drawn, the pixels
+// written to the panel and the host time per frame. the numbers are the
+// ones the firmware reports in registers e0 - ea, so that changes to the
+// drawing code can be compared without hardware.
+//
+// the panel is emulated at the spi level: commands, address windows, memory
+// write and write memory continue, so the framebuffer holds what the lcd
+// would show. after the replay the screen is redrawn from scratch; any
+// pixel that differs was left stale by the incremental updates.
+//
+// before the replay, reference frames of each grid are drawn and compared
+// against the hashes in referenceFrames.
+//
+// usage: render_bench [-s sweeps] [-b points per frame] [-p points] [-w] [file.s1p|s2p]
+// without a file, a synthetic resonator is swept over -p points, at most
+// SWEEP_POINTS_MAX. -w writes the screen of each format to
+// render_<width>x<height>_<format>.png.
+#include "globals.hpp"
+#include "plot.hpp"
+#include "ili9341.hpp"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <chrono>
+#include <random>
+#include <vector>
+
+typedef complex<double> complexd;
+
+// the commands of ili9341.cpp the panel emulation acts on
+#define ILI9341_COLUMN_ADDRESS_SET         0x2A
+#define ILI9341_PAGE_ADDRESS_SET           0x2B
+#define ILI9341_MEMORY_WRITE               0x2C
+#define ILI9341_WRITE_MEMORY_CONTINUE      0x3C
+
+// the panel: framebuffer in the byte order of ili9341_spi_buffer
+static struct {
+	uint16_t fb[LCD_HEIGHT][LCD_WIDTH];
+	uint8_t cmd;
+	int nargs;
+	uint8_t args[4];
+	int xs, xe, ys, ye, x, y;
+	bool half;
+	uint8_t first;
+} panel;
+
+static void panelPixel(uint16_t p) {
+	if(panel.x < LCD_WIDTH && panel.y < LCD_HEIGHT)
+		panel.fb[panel.y][panel.x] = p;
+	if(++panel.x > panel.xe) {
+		panel.x = panel.xs;
+		if(++panel.y > panel.ye)
+			panel.y = panel.ys;
+	}
+}
+
+static bool panelWriting() {
+	return panel.cmd == ILI9341_MEMORY_WRITE || panel.cmd == ILI9341_WRITE_MEMORY_CONTINUE;
+}
+
+static uint32_t panelTransfer(uint32_t sdi, int bits) {
+	if(hostPadLevel[ili9341_conf_dc & 63] == LOW) {
+		panel.cmd = sdi;
+		panel.nargs = 0;
+		panel.half = false;
+		if(panel.cmd == ILI9341_MEMORY_WRITE) {
+			panel.x = panel.xs;
+			panel.y = panel.ys;
+		}
+		return 0;
+	}
+	if(panelWriting()) {
+		if(bits == 16) {
+			panelPixel(byteReverse16(sdi));
+		} else if(panel.half) {
+			panelPixel(panel.first | (sdi << 8));
+			panel.half = false;
+		} else {
+			panel.first = sdi;
+			panel.half = true;
+		}
+		return 0;
+	}
+	if(panel.nargs < 4)
+		panel.args[panel.nargs++] = sdi;
+	if(panel.nargs == 4) {
+		int lo = panel.args[0] << 8 | panel.args[1];
+		int hi = panel.args[2] << 8 | panel.args[3];
+		if(panel.cmd == ILI9341_COLUMN_ADDRESS_SET) {
+			panel.xs = lo;
+			panel.xe = hi;
+		} else if(panel.cmd == ILI9341_PAGE_ADDRESS_SET) {
+			panel.ys = lo;
+			panel.ye = hi;
+		}
+	}
+	return 0;
+}
+
+static void panelTransferBulk(uint32_t words) {
+	if(!panelWriting())
+		return;
+	for(uint32_t i = 0; i < words; i++)
+		panelPixel(ili9341_spi_buffer[i]);
+}
+
+static void panelInit() {
+	ili9341_spi_set_cs = [](bool selected) {};
+	ili9341_spi_transfer = panelTransfer;
+	ili9341_spi_transfer_bulk = panelTransferBulk;
+	ili9341_spi_wait_bulk = []() {};
+	ili9341_spi_read = [](uint8_t *buf, uint32_t bytes) { memset(buf, 0, bytes); };
+	ili9341_init();
+}
+
+// png with stored (uncompressed) deflate blocks
+static uint32_t crc32(uint32_t crc, const uint8_t* p, size_t len) {
+	static uint32_t table[256];
+	if(!table[1])
+		for(uint32_t i = 0; i < 256; i++) {
+			uint32_t c = i;
+			for(int k = 0; k < 8; k++)
+				c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+			table[i] = c;
+		}
+	crc = ~crc;
+	while(len--)
+		crc = table[(crc ^ *p++) & 0xff] ^ (crc >> 8);
+	return ~crc;
+}
+
+static void put32(std::vector<uint8_t>& v, uint32_t x) {
+	for(int i = 24; i >= 0; i -= 8)
+		v.push_back(x >> i);
+}
+
+static void pngChunk(FILE* f, const char* type, const std::vector<uint8_t>& data) {
+	std::vector<uint8_t> c;
+	put32(c, data.size());
+	c.insert(c.end(), type, type + 4);
+	c.insert(c.end(), data.begin(), data.end());
+	put32(c, crc32(0, &c[4], c.size() - 4));
+	fwrite(c.data(), 1, c.size(), f);
+}
+
+static bool writePng(const char* name) {
+	FILE* f = fopen(name, "wb");
+	if(!f)
+		return false;
+	fwrite("\x89PNG\r\n\x1a\n", 1, 8, f);
+	std::vector<uint8_t> hdr;
+	put32(hdr, LCD_WIDTH);
+	put32(hdr, LCD_HEIGHT);
+	hdr.insert(hdr.end(), { 8, 2, 0, 0, 0 }); // 8 bit rgb
+	pngChunk(f, "IHDR", hdr);
+
+	std::vector<uint8_t> raw;
+	for(int y = 0; y < LCD_HEIGHT; y++) {
+		raw.push_back(0); // no filter
+		for(int x = 0; x < LCD_WIDTH; x++) {
+			uint16_t c = byteReverse16(panel.fb[y][x]);
+			raw.push_back((c >> 8 & 0xf8) | c >> 13);
+			raw.push_back((c >> 3 & 0xfc) | (c >> 9 & 3));
+			raw.push_back((c << 3 & 0xf8) | (c >> 2 & 7));
+		}
+	}
+	std::vector<uint8_t> z = { 0x78, 0x01 };
+	for(size_t i = 0; i < raw.size(); i += 65535) {
+		size_t n = raw.size() - i < 65535 ? raw.size() - i : 65535;
+		z.push_back(i + n == raw.size());
+		z.insert(z.end(), { uint8_t(n), uint8_t(n >> 8), uint8_t(~n), uint8_t(~n >> 8) });
+		z.insert(z.end(), raw.begin() + i, raw.begin() + i + n);
+	}
+	uint32_t a = 1, b = 0;
+	for(uint8_t c: raw) {
+		a = (a + c) % 65521;
+		b = (b + a) % 65521;
+	}
+	put32(z, b << 16 | a);
+	pngChunk(f, "IDAT", z);
+	pngChunk(f, "IEND", {});
+	return fclose(f) == 0;
+}
+
+// the sweep that is replayed: frequencies and S11, S21 per point
+static std::vector<double> sweepFreq;
+static std::vector<complexd> sweepData[2];
+
+// touchstone s1p or s2p; returns false if nothing could be read
+static bool loadTouchstone(const char* name) {
+	FILE* f = fopen(name, "r");
+	if(!f)
+		return false;
+	double unit = 1e9;
+	char format[8] = "MA";
+	char line[1024];
+	while(fgets(line, sizeof(line), f)) {
+		char* comment = strchr(line, '!');
+		if(comment)
+			*comment = 0;
+		if(line[0] == '#') {
+			for(char* tok = strtok(line + 1, " \t\r\n"); tok; tok = strtok(NULL, " \t\r\n")) {
+				if(!strcasecmp(tok, "HZ")) unit = 1;
+				else if(!strcasecmp(tok, "KHZ")) unit = 1e3;
+				else if(!strcasecmp(tok, "MHZ")) unit = 1e6;
+				else if(!strcasecmp(tok, "GHZ")) unit = 1e9;
+				else if(!strcasecmp(tok, "RI") || !strcasecmp(tok, "MA") || !strcasecmp(tok, "DB"))
+					snprintf(format, sizeof(format), "%s", tok);
+			}
+			continue;
+		}
+		double v[9];
+		int n = sscanf(line, "%lf %lf %lf %lf %lf %lf %lf %lf %lf",
+			&v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6], &v[7], &v[8]);
+		if(n < 3)
+			continue;
+		sweepFreq.push_back(v[0] * unit);
+		for(int ch = 0; ch < 2; ch++) {
+			// s2p columns are S11 S21 S12 S22
+			double p = n >= 9 || ch == 0 ? v[1 + 2 * ch] : 0, q = n >= 9 || ch == 0 ? v[2 + 2 * ch] : 0;
+			complexd s;
+			if(!strcasecmp(format, "RI"))
+				s = complexd(p, q);
+			else if(!strcasecmp(format, "DB"))
+				s = polar(pow(10, p / 20), q * M_PI / 180);
+			else
+				s = polar(p, q * M_PI / 180);
+			sweepData[ch].push_back(s);
+		}
+	}
+	fclose(f);
+	return sweepFreq.size() >= 2;
+}
+
+// a resonator at 500 MHz behind some line, reflection and transmission
+static void synthesize(int points) {
+	for(int i = 0; i < points; i++) {
+		double f = 100e6 + 800e6 * i / (points - 1);
+		double w = 2 * M_PI * f;
+		double detune = 20 * (f / 500e6 - 500e6 / f);
+		complexd z = complexd(30, 50 * detune);
+		sweepFreq.push_back(f);
+		sweepData[0].push_back((z - 50.) / (z + 50.) * polar(1., -w * 2e-10));
+		sweepData[1].push_back(0.9 / complexd(1, detune) * polar(1., -w * 5e-10));
+	}
+}
+
+struct result_t {
+	int frames = 0;
+	double cells = 0, pixels = 0, us = 0;
+	int stale = 0;
+};
+
+// points of the synthetic sweep; builds with a larger SWEEP_POINTS_MAX
+// set this to sweep more points than the screen has columns
+#ifndef BENCH_POINTS
+#define BENCH_POINTS 101
+#endif
+
+static int sweeps = 8, batch = 10, synthPoints = BENCH_POINTS;
+static bool writePngs = false;
+static std::mt19937 rng(1);
+
+static result_t replay(int type) {
+	result_t r;
+	current_props.setFieldsToDefault();
+	int points = sweepFreq.size() < SWEEP_POINTS_MAX ? sweepFreq.size() : SWEEP_POINTS_MAX;
+	sweep_points = points;
+	frequency0 = sweepFreq.front();
+	frequency1 = sweepFreq.back();
+	update_grid();
+	for(int t = 0; t < TRACES_MAX; t++) {
+		trace[t].enabled = t < 2;
+		trace[t].type = type;
+		trace[t].channel = t;
+		trace[t].polar = type == TRC_SMITH || type == TRC_POLAR;
+		trace[t].refpos = trace_info[type].refpos;
+	}
+	// a marker near the resonance
+	markers[0].index = points / 2;
+	memset(measured, 0, sizeof(measured));
+
+	redraw_frame();
+	request_to_redraw_grid();
+	plot_into_index(measured);
+	force_set_markmap();
+	draw_all(true);
+
+	// each sweep is the recorded one plus noise, so that every point moves
+	std::normal_distribution<float> noise(0, 2e-3f);
+	for(int s = 0; s < sweeps; s++) {
+		for(int i0 = 0; i0 < points; i0 += batch) {
+			int i1 = i0 + batch < points ? i0 + batch : points;
+			for(int i = i0; i < i1; i++) {
+				size_t k = i * (sweepFreq.size() - 1) / (points - 1);
+				for(int ch = 0; ch < 2; ch++)
+					measured[ch][i] = complexf(sweepData[ch][k]) + complexf(noise(rng), noise(rng));
+			}
+			plot_points_changed(i0, i1 - 1);
+
+			uint32_t pixels0 = ili9341_pixels_written;
+			plot_cells_drawn = 0;
+			auto t0 = std::chrono::steady_clock::now();
+			plot_into_index_changed(measured);
+			draw_all(true);
+			auto t1 = std::chrono::steady_clock::now();
+			r.frames++;
+			r.cells += plot_cells_drawn;
+			r.pixels += ili9341_pixels_written - pixels0;
+			r.us += std::chrono::duration<double, std::micro>(t1 - t0).count();
+		}
+	}
+
+	// compare against a redraw from scratch
+	static uint16_t incremental[LCD_HEIGHT][LCD_WIDTH];
+	memcpy(incremental, panel.fb, sizeof(incremental));
+	redraw_frame();
+	request_to_redraw_grid();
+	force_set_markmap();
+	draw_all(true);
+	for(int y = 0; y < LCD_HEIGHT; y++)
+		for(int x = 0; x < LCD_WIDTH; x++)
+			if(incremental[y][x] != panel.fb[y][x]) {
+				if(r.stale++ == 0)
+					fprintf(stderr, "%s: stale pixel at %d, %d\n", trace_info[type].name, x, y);
+			}
+
+	if(writePngs) {
+		char name[64];
+		snprintf(name, sizeof(name), "render_%dx%d_%s.png", LCD_WIDTH, LCD_HEIGHT, trace_info[type].name);
+		if(!writePng(name))
+			fprintf(stderr, "can not write %s\n", name);
+	}
+	return r;
+}
+
+// reference frames: one trace of a constant reflection over each grid, no
+// markers, drawn from scratch. the hashes are of the whole framebuffer, so
+// any change to how the grid, the trace or the labels look changes them;
+// -w writes the frames to render_<width>x<height>_grid_<format>.png, and
+// the table is updated when the change is intended.
+static const struct {
+	int type;
+	uint32_t hash;
+} referenceFrames[] = {
+#ifdef DISPLAY_ST7796
+	{ TRC_LOGMAG, 0xa534c939 },
+	{ TRC_SMITH, 0x2e0d9253 },
+	{ TRC_POLAR, 0x978fcbd3 },
+#else
+	{ TRC_LOGMAG, 0x10cfd7ce },
+	{ TRC_SMITH, 0x7940a9e6 },
+	{ TRC_POLAR, 0x833dd3e6 },
+#endif
+};
+
+// fnv-1a of the framebuffer
+static uint32_t panelHash() {
+	uint32_t h = 2166136261u;
+	const uint8_t* p = (const uint8_t*) panel.fb;
+	for(size_t i = 0; i < sizeof(panel.fb); i++)
+		h = (h ^ p[i]) * 16777619u;
+	return h;
+}
+
+static uint32_t referenceFrame(int type) {
+	current_props.setFieldsToDefault();
+	sweep_points = 101;
+	frequency0 = 100000000;
+	frequency1 = 900000000;
+	update_grid();
+	for(int t = 0; t < TRACES_MAX; t++) {
+		trace[t].enabled = t == 0;
+		trace[t].type = type;
+		trace[t].channel = 0;
+		trace[t].polar = type == TRC_SMITH || type == TRC_POLAR;
+		trace[t].refpos = trace_info[type].refpos;
+	}
+	for(int m = 0; m < MARKERS_MAX; m++)
+		markers[m].enabled = false;
+	active_marker = MARKER_INVALID;
+	for(int i = 0; i < sweep_points; i++)
+		measured[0][i] = measured[1][i] = complexf(0.3f, 0.2f);
+
+	redraw_frame();
+	request_to_redraw_grid();
+	plot_into_index(measured);
+	force_set_markmap();
+	draw_all(true);
+	if(writePngs) {
+		char name[64];
+		snprintf(name, sizeof(name), "render_%dx%d_grid_%s.png", LCD_WIDTH, LCD_HEIGHT, trace_info[type].name);
+		if(!writePng(name))
+			fprintf(stderr, "can not write %s\n", name);
+	}
+	return panelHash();
+}
+
+int main(int argc, char** argv) {
+	int opt;
+	while((opt = getopt(argc, argv, "s:b:p:w")) != -1) {
+		switch(opt) {
+		case 's': sweeps = atoi(optarg); break;
+		case 'b': batch = atoi(optarg); break;
+		case 'p': synthPoints = atoi(optarg); break;
+		case 'w': writePngs = true; break;
+		default:
+			fprintf(stderr, "usage: %s [-s sweeps] [-b points per frame] [-p points] [-w] [file.s1p|s2p]\n", argv[0]);
+			return 2;
+		}
+	}
+	if(optind < argc) {
+		if(!loadTouchstone(argv[optind])) {
+			fprintf(stderr, "can not read %s\n", argv[optind]);
+			return 2;
+		}
+	} else {
+		if(synthPoints < 2)
+			return 2;
+		synthesize(synthPoints);
+	}
+	if(sweeps < 1 || batch < 1)
+		return 2;
+
+	panelInit();
+	plot_getFrequencyAt = [](int i) {
+		return (freqHz_t)(frequency0 + (double)(frequency1 - frequency0) * i / (sweep_points - 1));
+	};
+	plot_tick = []() {};
+	plot_init();
+
+	int mismatches = 0;
+	for(auto& ref: referenceFrames) {
+		uint32_t hash = referenceFrame(ref.type);
+		printf("reference frame %-8s %08x%s\n", trace_info[ref.type].name, hash,
+			hash == ref.hash ? "" : "  FAIL");
+		if(hash != ref.hash)
+			mismatches++;
+	}
+
+	int points = sweepFreq.size() < SWEEP_POINTS_MAX ? sweepFreq.size() : SWEEP_POINTS_MAX;
+	printf("%dx%d, %d points, %d sweeps, %d points per frame\n", LCD_WIDTH, LCD_HEIGHT, points, sweeps, batch);
+	printf("%-8s %7s %12s %13s %9s %6s\n", "format", "frames", "cells/frame", "pixels/frame", "us/frame", "stale");
+	int stale = 0;
+	for(int type = 0; type < TRC_OFF; type++) {
+		result_t r = replay(type);
+		printf("%-8s %7d %12.1f %13.0f %9.1f %6d\n", trace_info[type].name, r.frames,
+			r.cells / r.frames, r.pixels / r.frames, r.us / r.frames, r.stale);
+		stale += r.stale;
+	}
+	return stale || mismatches ? 1 : 0;
+}
@@ -51,7 +51,9 @@ enum {
 };
 
 enum {
-  KM_START, KM_STOP, KM_CENTER, KM_SPAN, KM_POINTS, KM_CW, KM_SCALE, KM_REFPOS, KM_EDELAY, KM_VELOCITY_FACTOR, KM_SCALEDELAY
+  KM_START, KM_STOP, KM_CENTER, KM_SPAN, KM_POINTS, KM_CW, KM_SCALE, KM_REFPOS, KM_EDELAY, KM_VELOCITY_FACTOR, KM_SCALEDELAY,
+  KM_TD_KAISER_BETA, KM_TD_CHEBYSHEV_ATTEN, KM_TD_ZOOM_START, KM_TD_ZOOM_STOP,
+  KM_TD_GATE_START, KM_TD_GATE_STOP
 };
 
 uint8_t ui_mode = UI_NORMAL;
@@ -583,6 +585,34 @@ static UI_FUNCTION_ADV_CALLBACK(menu_trace_acb)
   draw_menu();
 }
 
+static UI_FUNCTION_CALLBACK(menu_trace_memory_cb)
+{
+  (void)item;
+  (void)data;
+  if (uistat.current_trace < 0)
+    return;
+  trace_memory_store(trace[uistat.current_trace].channel);
+  plot_into_index(measured);
+  request_to_redraw_grid();
+  ui_mode_normal();
+}
+
+static UI_FUNCTION_ADV_CALLBACK(menu_trace_math_acb)
+{
+  (void)item;
+  if (uistat.current_trace < 0)
+    return;
+  if (b){
+    if (trace_math[uistat.current_trace] == data)
+      b->icon = BUTTON_ICON_CHECK;
+    return;
+  }
+  trace_math[uistat.current_trace] = data;
+  plot_into_index(measured);
+  request_to_redraw_grid();
+  draw_menu();
+}
+
 static UI_FUNCTION_ADV_CALLBACK(menu_format_acb)
 {
   (void)item;
@@ -609,16 +639,29 @@ static UI_FUNCTION_ADV_CALLBACK(menu_channel_acb)
   menu_move_back(true);
 }
 
+// time domain window parameters are stored as uint8_t
+static uint8_t clamp_td_window_param(float value)
+{
+  if (value < 0) return 0;
+  if (value > 255) return 255;
+  return (uint8_t)(value + 0.5f);
+}
+
 static UI_FUNCTION_ADV_CALLBACK(menu_transform_window_acb)
 {
   (void)item;
-  // TODO
   if(b){
-    b->icon = (domain_mode & TD_WINDOW) == data ? BUTTON_ICON_GROUP_CHECKED : BUTTON_ICON_GROUP;
+    b->icon = (domain_mode & (TD_WINDOW | TD_WINDOW_TYPE)) == data ? BUTTON_ICON_GROUP_CHECKED : BUTTON_ICON_GROUP;
     return;
   }
-  domain_mode = (domain_mode & ~TD_WINDOW) | data;
-  ui_mode_normal();
+  domain_mode = (domain_mode & ~(TD_WINDOW | TD_WINDOW_TYPE)) | data;
+  // windows with a parameter prompt for it
+  if (data == TD_WINDOW_KAISER)
+    ui_mode_keypad(KM_TD_KAISER_BETA);
+  else if (data == TD_WINDOW_CHEBYSHEV)
+    ui_mode_keypad(KM_TD_CHEBYSHEV_ATTEN);
+  else
+    ui_mode_normal();
 }
 
 static UI_FUNCTION_ADV_CALLBACK(menu_transform_acb)
@@ -645,6 +688,34 @@ static UI_FUNCTION_ADV_CALLBACK(menu_transform_filter_acb)
   ui_mode_normal();
 }
 
+static UI_FUNCTION_CALLBACK(menu_transform_zoom_off_cb)
+{
+  (void)item;
+  (void)data;
+  td_zoom_start = 0;
+  td_zoom_stop = 0;
+  ui_mode_normal();
+}
+
+static UI_FUNCTION_ADV_CALLBACK(menu_transform_gate_acb)
+{
+  (void)item;
+  if(b){
+    b->icon = td_gate_shape == data ? BUTTON_ICON_GROUP_CHECKED : BUTTON_ICON_GROUP;
+    return;
+  }
+  td_gate_shape = data;
+  ui_mode_normal();
+}
+
+static UI_FUNCTION_CALLBACK(menu_transform_gate_off_cb)
+{
+  (void)item;
+  (void)data;
+  td_gate_start = 0;
+  td_gate_stop = 0;
+  ui_mode_normal();
+}
 
 static UI_FUNCTION_ADV_CALLBACK(menu_avg_acb)
 {
@@ -957,11 +1028,22 @@ const menuitem_t menu_cal[] = {
   { MT_NONE, 0, NULL, NULL } // sentinel
 };
 
+const menuitem_t menu_trace_math[] = {
+  { MT_ADV_CALLBACK, TRACE_MATH_OFF, "MATH OFF", (const void *)menu_trace_math_acb },
+  { MT_ADV_CALLBACK, TRACE_MATH_MEMORY, "MEMORY", (const void *)menu_trace_math_acb },
+  { MT_ADV_CALLBACK, TRACE_MATH_SUB, "DATA-MEM", (const void *)menu_trace_math_acb },
+  { MT_ADV_CALLBACK, TRACE_MATH_DIV, "DATA/MEM", (const void *)menu_trace_math_acb },
+  { MT_CANCEL, 0, S_LARROW" BACK", NULL },
+  { MT_NONE, 0, NULL, NULL } // sentinel
+};
+
 const menuitem_t menu_trace[] = {
   { MT_ADV_CALLBACK, 0, "TRACE 0", (const void *)menu_trace_acb },
   { MT_ADV_CALLBACK, 1, "TRACE 1", (const void *)menu_trace_acb },
   { MT_ADV_CALLBACK, 2, "TRACE 2", (const void *)menu_trace_acb },
   { MT_ADV_CALLBACK, 3, "TRACE 3", (const void *)menu_trace_acb },
+  { MT_CALLBACK, 0, "SAVE\nMEMORY", (const void *)menu_trace_memory_cb },
+  { MT_SUBMENU, 0, "MATH", (const void *)menu_trace_math },
   { MT_CANCEL, 0, S_LARROW" BACK", NULL },
   { MT_NONE, 0, NULL, NULL } // sentinel
 };
@@ -1011,6 +1093,30 @@ const menuitem_t menu_transform_window[] = {
   { MT_ADV_CALLBACK, TD_WINDOW_MINIMUM, "MINIMUM", (const void *)menu_transform_window_acb },
   { MT_ADV_CALLBACK, TD_WINDOW_NORMAL,   "NORMAL", (const void *)menu_transform_window_acb },
   { MT_ADV_CALLBACK, TD_WINDOW_MAXIMUM, "MAXIMUM", (const void *)menu_transform_window_acb },
+  { MT_ADV_CALLBACK, TD_WINDOW_HANN, "HANN", (const void *)menu_transform_window_acb },
+  { MT_ADV_CALLBACK, TD_WINDOW_BLACKMAN_HARRIS, "BLACKMAN\nHARRIS", (const void *)menu_transform_window_acb },
+  { MT_ADV_CALLBACK, TD_WINDOW_KAISER, "KAISER\nBETA", (const void *)menu_transform_window_acb },
+  { MT_ADV_CALLBACK, TD_WINDOW_CHEBYSHEV, "CHEBYSHEV\nSIDELOBE", (const void *)menu_transform_window_acb },
+  { MT_CANCEL, 0, S_LARROW" BACK", NULL },
+  { MT_NONE, 0, NULL, NULL } // sentinel
+};
+
+const menuitem_t menu_transform_gate_shape[] = {
+  { MT_ADV_CALLBACK, TD_WINDOW_MINIMUM, "MINIMUM", (const void *)menu_transform_gate_acb },
+  { MT_ADV_CALLBACK, TD_WINDOW_NORMAL, "NORMAL", (const void *)menu_transform_gate_acb },
+  { MT_ADV_CALLBACK, TD_WINDOW_MAXIMUM, "MAXIMUM", (const void *)menu_transform_gate_acb },
+  { MT_CANCEL, 0, S_LARROW" BACK", NULL },
+  { MT_NONE, 0, NULL, NULL } // sentinel
+};
+
+const menuitem_t menu_transform_zoom_gate[] = {
+  { MT_CALLBACK, KM_TD_ZOOM_START, "ZOOM\nSTART", (const void *)menu_keyboard_cb },
+  { MT_CALLBACK, KM_TD_ZOOM_STOP, "ZOOM\nSTOP", (const void *)menu_keyboard_cb },
+  { MT_CALLBACK, 0, "ZOOM\nOFF", (const void *)menu_transform_zoom_off_cb },
+  { MT_CALLBACK, KM_TD_GATE_START, "GATE\nSTART", (const void *)menu_keyboard_cb },
+  { MT_CALLBACK, KM_TD_GATE_STOP, "GATE\nSTOP", (const void *)menu_keyboard_cb },
+  { MT_SUBMENU, 0, "GATE\nSHAPE", (const void *)menu_transform_gate_shape },
+  { MT_CALLBACK, 0, "GATE\nOFF", (const void *)menu_transform_gate_off_cb },
   { MT_CANCEL, 0, S_LARROW" BACK", NULL },
   { MT_NONE, 0, NULL, NULL } // sentinel
 };
@@ -1021,6 +1127,9 @@ const menuitem_t menu_transform[] = {
   { MT_ADV_CALLBACK, TD_FUNC_LOWPASS_STEP, "LOW PASS\nSTEP", (const void *)menu_transform_filter_acb },
   { MT_ADV_CALLBACK, TD_FUNC_BANDPASS, "BANDPASS", (const void *)menu_transform_filter_acb },
   { MT_SUBMENU, 0, "WINDOW", (const void *)menu_transform_window },
+#if TD_SECOND_BUFFER
+  { MT_SUBMENU, 0, "ZOOM/GATE", (const void *)menu_transform_zoom_gate },
+#endif
   { MT_CALLBACK, KM_VELOCITY_FACTOR, "VELOCITY\nFACTOR", (const void *)menu_keyboard_cb },
   { MT_CANCEL, 0, S_LARROW" BACK", NULL },
   { MT_NONE, 0, NULL, NULL } // sentinel
@@ -1374,11 +1483,19 @@ static const keypads_t * const keypads_mode_tbl[] = {
   keypads_scale, // refpos
   keypads_time, // electrical delay
   keypads_scale, // velocity factor
-  keypads_time // scale of delay
+  keypads_time, // scale of delay
+  keypads_scale, // kaiser window beta
+  keypads_scale, // chebyshev window sidelobe attenuation
+  keypads_time, // time domain zoom start
+  keypads_time, // time domain zoom stop
+  keypads_time, // time gate start
+  keypads_time // time gate stop
 };
 
 const char * const keypad_mode_label[] = {
-  "START", "STOP", "CENTER", "SPAN", "POINTS", "CW FREQ", "SCALE", "REFPOS", "EDELAY", "VELOCITY%", "DELAY"
+  "START", "STOP", "CENTER", "SPAN", "POINTS", "CW FREQ", "SCALE", "REFPOS", "EDELAY", "VELOCITY%", "DELAY",
+  "BETA", "SIDELOBE", "T START", "T STOP",
+  "G START", "G STOP"
 };
 
 static void
@@ -1533,10 +1650,8 @@ menu_item_modify_attribute(const menuitem_t *menu, int item,
         *fg = 0xffff;
       }
   } else if (menu == menu_transform_window) {
-      if ((item == 0 && (domain_mode & TD_WINDOW) == TD_WINDOW_MINIMUM)
-       || (item == 1 && (domain_mode & TD_WINDOW) == TD_WINDOW_NORMAL)
-       || (item == 2 && (domain_mode & TD_WINDOW) == TD_WINDOW_MAXIMUM)
-       ) {
+      if (menu[item].type == MT_ADV_CALLBACK
+       && (domain_mode & (TD_WINDOW | TD_WINDOW_TYPE)) == menu[item].data) {
         *bg = 0x0000;
         *fg = 0xffff;
       }
@@ -1810,6 +1925,30 @@ ui_mode_normal(void)
   ui_mode = UI_NORMAL;
 }
 
+// repaint the whole screen from the current ui state instead of only the
+// parts that changed, e.g. to start a capture stream
+void
+ui_redraw_screen(void)
+{
+  if (ui_mode == UI_USB_MODE) {
+    ui_mode_usb();
+    return;
+  }
+  redraw_frame();
+  request_to_redraw_grid();
+  redraw_request |= 0xff;
+  draw_all(true);
+  if (ui_mode == UI_MENU)
+    draw_menu();
+  if (ui_mode == UI_KEYPAD) {
+    draw_menu();
+    draw_keypad();
+    draw_numeric_area_frame();
+    if (kp_index > 0)
+      draw_numeric_input(kp_buf);
+  }
+}
+
 static void
 lever_move_marker(UIEvent evt)
 {
@@ -2008,6 +2147,24 @@ keypad_click(int key)
     case KM_SCALEDELAY:
       set_trace_scale(uistat.current_trace, value * 1e-12); // pico second
       break;
+    case KM_TD_KAISER_BETA:
+      current_props._td_kaiser_beta = clamp_td_window_param(value * 10);
+      break;
+    case KM_TD_CHEBYSHEV_ATTEN:
+      current_props._td_chebyshev_atten = clamp_td_window_param(value);
+      break;
+    case KM_TD_ZOOM_START:
+      td_zoom_start = value * 1e-12; // pico second
+      break;
+    case KM_TD_ZOOM_STOP:
+      td_zoom_stop = value * 1e-12; // pico second
+      break;
+    case KM_TD_GATE_START:
+      td_gate_start = value * 1e-12; // pico second
+      break;
+    case KM_TD_GATE_STOP:
+      td_gate_stop = value * 1e-12; // pico second
+      break;
     }
 
     return KP_DONE;
@@ -74,6 +74,7 @@ void ui_enter_bootload(void);
 void ui_mode_normal(void);
 void ui_mode_menu(void);
 void ui_mode_usb(void);
+void ui_redraw_screen(void);
 void draw_numeric_input(const char *buf);
 void draw_menu();
 
@@ -29,6 +29,62 @@ void VNAMeasurement::resetSweep() {
 	sweepCurrPoint = -1;
 }
 
+// number of consecutive stable ecal updates before a region's interval is doubled
+static constexpr int ecalStableUpdates = 16;
+
+int VNAMeasurement::ecalRegion(int freqIndex) const {
+	if(freqIndex < 0 || sweepPoints <= 1)
+		return 0;
+	return freqIndex * ECAL_REGIONS / sweepPoints;
+}
+
+// ecal interval in effect at the current sweep point
+uint32_t VNAMeasurement::ecalInterval() const {
+	uint32_t interval = ecalIntervalPoints;
+	if(interval <= 1)
+		return interval;
+	return interval << ecalIntervalShift[ecalRegion(sweepCurrPoint)];
+}
+
+// ecal is measured at point p of sweep s when p + s is a multiple of the
+// interval I of p's region. for a fixed p, p + s runs through all residues
+// mod I in I consecutive sweeps, so every point gets exactly one ecal
+// update per I sweeps, and each sweep measures ecal at one in I points.
+bool VNAMeasurement::ecalDue() const {
+	uint32_t interval = ecalInterval();
+	if(interval <= 1)
+		return true;
+	return (sweepCurrPoint + ecalPhase) % interval == 0;
+}
+
+void VNAMeasurement::ecalDriftUpdate(int freqIndex, float drift) {
+	int r = ecalRegion(freqIndex);
+	ecalDrift[r] = ecalDrift[r] * 0.75f + drift * 0.25f;
+	if(drift > ecalDriftUnstable || ecalDrift[r] > ecalDriftUnstable) {
+		// sudden change (temperature, gain); track it at the full rate again
+		ecalDrift[r] = drift;
+		ecalStableCount[r] = 0;
+		ecalIntervalShift[r] = 0;
+		return;
+	}
+	if(ecalDrift[r] > ecalDriftStable) {
+		ecalStableCount[r] = 0;
+		return;
+	}
+	if(++ecalStableCount[r] < ecalStableUpdates)
+		return;
+	ecalStableCount[r] = 0;
+	if(ecalIntervalShift[r] < ecalIntervalMaxShift)
+		ecalIntervalShift[r]++;
+}
+
+void VNAMeasurement::ecalIntervalReset() {
+	for(int r = 0; r < ECAL_REGIONS; r++) {
+		ecalDrift[r] = 0;
+		ecalStableCount[r] = 0;
+		ecalIntervalShift[r] = 0;
+	}
+}
 
 void VNAMeasurement::setMeasurementPhase(VNAMeasurementPhases ph) {
 	phaseChanged(ph);
@@ -66,10 +122,14 @@ void VNAMeasurement::sweepAdvance() {
 	if(sweepCurrPoint == 0) {
 		periodCounterSynth = BOARD_MEASUREMENT_FIRST_POINT_WAIT; // for first point need more wait
 		currThruGain = gainMax;
-		ecalCounter = ecalCounterOffset;
-		ecalCounterOffset++;
-		if(ecalCounterOffset >= ecalIntervalPoints)
-			ecalCounterOffset = 0;
+		// every interval divides the longest one, so wrapping there keeps
+		// the phase of all regions
+		uint32_t maxInterval = ecalIntervalPoints;
+		if(maxInterval > 1)
+			maxInterval <<= ecalIntervalMaxShift;
+		ecalPhase++;
+		if(ecalPhase >= maxInterval)
+			ecalPhase = 0;
 	}
 }
 
@@ -82,7 +142,7 @@ void VNAMeasurement::sampleProcessor_emitValue(int32_t valRe, int32_t valIm, boo
 		sweepSetupChanged(start, stop);
 		dpCounterSynth = 0;
 		setMeasurementPhase(VNAMeasurementPhases::REFERENCE);
-		ecalCounterOffset = 0;
+		ecalPhase = 0;
 		sweepAdvance();
 		return;
 	}
@@ -160,7 +220,7 @@ void VNAMeasurement::sampleProcessor_emitValue(int32_t valRe, int32_t valIm, boo
 					setMeasurementPhase(VNAMeasurementPhases::REFERENCE);
 					doEmitValue(false);
 #else
-					if(ecalCounter == 0) {
+					if(ecalDue()) {
 #ifdef ECAL_PARTIAL
 						setMeasurementPhase(VNAMeasurementPhases::ECALLOAD);
 #else
@@ -170,9 +230,6 @@ void VNAMeasurement::sampleProcessor_emitValue(int32_t valRe, int32_t valIm, boo
 						setMeasurementPhase(VNAMeasurementPhases::REFERENCE);
 						doEmitValue(false);
 					}
-					ecalCounter++;
-					if(ecalCounter >= ecalIntervalPoints)
-						ecalCounter = 0;
 #endif
 					break;
 				case MEASURE_MODE_REFL_THRU_REFRENCE: /* AKA no ECAL */
@@ -38,6 +38,16 @@ public:
 	// every ecalIntervalPoints we will measure one frequency point for ecal
 	uint16_t ecalIntervalPoints = 8;
 
+	// adaptive ecal interval: the sweep is split into ECAL_REGIONS regions and
+	// the ecal interval of each region is doubled (at most ecalIntervalMaxShift
+	// times) while the drift reported through ecalDriftUpdate() stays below
+	// ecalDriftStable. it falls back to ecalIntervalPoints when the drift
+	// exceeds ecalDriftUnstable.
+	static constexpr int ECAL_REGIONS = 8;
+	uint8_t ecalIntervalMaxShift = 3;
+	float ecalDriftStable = 1e-4f;
+	float ecalDriftUnstable = 1e-3f;
+
 	// AGC parameters; VNAMeasurement will detect ADC clip events and inform the
 	// host when baseband/rf gain needs to be changed.
 	uint8_t gainMin = 0, gainMax = 3;
@@ -84,6 +94,13 @@ public:
 
 	void resetSweep();
 
+	// report the drift of the ecal estimate at freqIndex, as the squared
+	// magnitude of the change relative to the current estimate.
+	void ecalDriftUpdate(int freqIndex, float drift);
+
+	// measure ecal every ecalIntervalPoints in all regions again
+	void ecalIntervalReset();
+
 	struct _emitValue_t {
 		VNAMeasurement* m;
 		void operator()(int32_t* valRe, int32_t* valIm);
@@ -104,9 +121,13 @@ public:
 	// number of data points since synthesizer frequency change
 	uint32_t dpCounterSynth = 0;
 
-	// counts up every data point; resets when it reaches ecalIntervalPoints
-	uint32_t ecalCounter = 0;
-	uint32_t ecalCounterOffset = 0;
+	// counts sweeps modulo the longest ecal interval; see ecalDue()
+	uint32_t ecalPhase = 0;
+
+	// per region adaptive ecal interval state
+	float ecalDrift[ECAL_REGIONS] = {};
+	uint8_t ecalStableCount[ECAL_REGIONS] = {};
+	uint8_t ecalIntervalShift[ECAL_REGIONS] = {};
 
 	// What measurements to make
 	enum MeasurementMode measurement_mode = MEASURE_MODE_FULL;
@@ -133,6 +154,9 @@ public:
 	complexf ecal[ECAL_CHANNELS];
 
 
+	int ecalRegion(int freqIndex) const;
+	uint32_t ecalInterval() const;
+	bool ecalDue() const;
 	void setMeasurementPhase(VNAMeasurementPhases ph);
 	void sweepAdvance();
 	void sampleProcessor_emitValue(int32_t valRe, int32_t valIm, bool clipped);